@@ -0,0 +1,329 @@
+// System Includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisClient.h"
+
+// Share of hiredis' own work that goes to its allocator, with malloc and with the pool.
+//
+// Usage: redisclient_allocator_bench [ops]
+//
+// Each workload is timed as a whole, then the exact sequence of allocator calls it
+// makes is recorded once and replayed on its own, so the allocator's part of every
+// operation is measured without a profiler. The replay loop's own cost, taken by
+// replaying through allocator functions that do nothing, is subtracted. Every figure is
+// the best of a few repetitions. The malloc runs come first as the pool can only be
+// installed once. Results are printed to stdout as one JSON document.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int repetitions = 5;
+
+    struct Workload
+    {
+        std::string name;
+        std::function<void()> operation;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::string allocator;
+        double nanosPerOp = 0;
+        double allocationsPerOp = 0;
+        double allocatorNanosPerOp = 0;
+        double allocatorNanosPerCall = 0;
+    };
+
+    // One allocator call, pointers are replaced by the slot they are kept in
+    struct Event
+    {
+        enum Kind { Malloc, Calloc, Realloc, Free } kind;
+        size_t size = 0;
+        size_t slot = 0;            // Result slot, or the slot freed or resized
+        size_t target = 0;          // Slot a realloc result goes to
+    };
+
+    struct Trace
+    {
+        std::vector<Event> events;
+        size_t slots = 0;
+        size_t allocations = 0;
+        double replayOverhead = 0;      // Nanoseconds per round spent in the replay loop itself
+    };
+
+    Trace* recording = nullptr;
+    std::unordered_map<void*, size_t> recordedSlots;
+
+    size_t recordSlot(void* pointer)
+    {
+        recordedSlots[pointer] = recording->slots;
+        return recording->slots++;
+    }
+
+    // Every block freed or resized while recording must have been allocated while recording
+    size_t slotOf(void* pointer)
+    {
+        auto found = recordedSlots.find(pointer);
+        if (found == recordedSlots.end()) {
+            std::fprintf(stderr, "Workload touched a block allocated before recording\n");
+            std::abort();
+        }
+        size_t slot = found->second;
+        recordedSlots.erase(found);
+        return slot;
+    }
+
+    void* recordMalloc(size_t size)
+    {
+        void* pointer = std::malloc(size);
+        recording->events.push_back({Event::Malloc, size, recordSlot(pointer), 0});
+        ++recording->allocations;
+        return pointer;
+    }
+
+    void* recordCalloc(size_t count, size_t size)
+    {
+        void* pointer = std::calloc(count, size);
+        recording->events.push_back({Event::Calloc, count * size, recordSlot(pointer), 0});
+        ++recording->allocations;
+        return pointer;
+    }
+
+    void* recordRealloc(void* previous, size_t size)
+    {
+        size_t from = previous ? slotOf(previous) : 0;
+        void* pointer = std::realloc(previous, size);
+        size_t to = recordSlot(pointer);
+        recording->events.push_back({previous ? Event::Realloc : Event::Malloc, size, previous ? from : to, to});
+        ++recording->allocations;
+        return pointer;
+    }
+
+    char* recordStrdup(const char* string)
+    {
+        size_t length = std::strlen(string) + 1;
+        char* copy = static_cast<char*>(recordMalloc(length));
+        std::memcpy(copy, string, length);
+        return copy;
+    }
+
+    void recordFree(void* pointer)
+    {
+        if (pointer != nullptr) {
+            recording->events.push_back({Event::Free, 0, slotOf(pointer), 0});
+        }
+        std::free(pointer);
+    }
+
+    Trace record(const Workload& workload, int operations)
+    {
+        // Buffers the workload keeps between operations are grown before recording starts
+        for (int i = 0; i < operations; ++i) {
+            workload.operation();
+        }
+
+        Trace trace;
+        recording = &trace;
+        hiredisAllocFuncs functions = {recordMalloc, recordCalloc, recordRealloc, recordStrdup, recordFree};
+        hiredisSetAllocators(&functions);
+        for (int i = 0; i < operations; ++i) {
+            workload.operation();
+        }
+        hiredisResetAllocators();
+        recording = nullptr;
+        recordedSlots.clear();
+        return trace;
+    }
+
+    // Replays a trace through whatever allocator hiredis has installed, the best
+    // nanoseconds per round
+    double replay(const Trace& trace, int rounds)
+    {
+        std::vector<void*> slots(trace.slots);
+        double best = 0;
+        for (int repetition = 0; repetition <= repetitions; ++repetition) {
+            auto begin = Clock::now();
+            for (int round = 0; round < rounds; ++round) {
+                for (const Event& event : trace.events) {
+                    switch (event.kind) {
+                        case Event::Malloc: slots[event.slot] = hi_malloc(event.size); break;
+                        case Event::Calloc: slots[event.slot] = hi_calloc(1, event.size); break;
+                        case Event::Realloc: slots[event.target] = hi_realloc(slots[event.slot], event.size); break;
+                        case Event::Free: hi_free(slots[event.slot]); break;
+                    }
+                }
+            }
+            double nanos = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / rounds;
+            // The first repetition warms up
+            if (repetition > 0 && (best == 0 || nanos < best)) {
+                best = nanos;
+            }
+        }
+        return best;
+    }
+
+    // Stands in for an allocator so a replay times only its own loop
+    char nothing[16];
+    void* nullMalloc(size_t) { return nothing; }
+    void* nullCalloc(size_t, size_t) { return nothing; }
+    void* nullRealloc(void*, size_t) { return nothing; }
+    char* nullStrdup(const char*) { return nothing; }
+    void nullFree(void*) {}
+
+    void measureOverhead(Trace& trace, int rounds)
+    {
+        hiredisAllocFuncs functions = {nullMalloc, nullCalloc, nullRealloc, nullStrdup, nullFree};
+        hiredisSetAllocators(&functions);
+        trace.replayOverhead = replay(trace, rounds);
+        hiredisResetAllocators();
+    }
+
+    double time(const Workload& workload, uint64_t operations)
+    {
+        for (uint64_t i = 0; i < operations / 10; ++i) {
+            workload.operation();
+        }
+        double best = 0;
+        for (int repetition = 0; repetition < repetitions; ++repetition) {
+            auto begin = Clock::now();
+            for (uint64_t i = 0; i < operations; ++i) {
+                workload.operation();
+            }
+            double nanos = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / operations;
+            if (repetition == 0 || nanos < best) {
+                best = nanos;
+            }
+        }
+        return best;
+    }
+
+    // A reader kept across replies like a connection's, so only the replies allocate
+    std::function<void()> parser(const std::string& reply)
+    {
+        std::shared_ptr<redisReader> reader(redisReaderCreate(), redisReaderFree);
+        return [reader, reply]() {
+            void* parsed = nullptr;
+            redisReaderFeed(reader.get(), reply.data(), reply.size());
+            redisReaderGetReply(reader.get(), &parsed);
+            freeReplyObject(parsed);
+        };
+    }
+
+    std::string bulk(const std::string& value)
+    {
+        return "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+    }
+
+    std::vector<Workload> workloads()
+    {
+        std::string array = "*100\r\n";
+        for (int i = 0; i < 100; ++i) {
+            array += bulk("value" + std::to_string(100 + i));
+        }
+        std::string message = "*3\r\n" + bulk("message") + bulk("sensor:floor2:temperature") +
+                              bulk("{\"celsius\":21.5,\"sequence\":184467}");
+        std::string hash = "*20\r\n";
+        for (int i = 0; i < 10; ++i) {
+            hash += bulk("field:" + std::to_string(i)) + ":" + std::to_string(1000 * i) + "\r\n";
+        }
+
+        std::vector<Workload> result;
+        result.push_back({"reply_parse_array100", parser(array)});
+        result.push_back({"reply_parse_pubsub_message", parser(message)});
+        result.push_back({"reply_parse_mixed_array20", parser(hash)});
+        result.push_back({"format_set_command", []() {
+            const char* argv[] = {"SET", "sensor:floor2:temperature", "21.5"};
+            char* command = nullptr;
+            redisFormatCommandArgv(&command, 3, argv, nullptr);
+            redisFreeCommand(command);
+        }});
+        return result;
+    }
+
+    int rounds(uint64_t operations, int traced)
+    {
+        return static_cast<int>(std::max<uint64_t>(operations / traced, 1));
+    }
+
+    Result measure(const Workload& workload, const Trace& trace, int traced, uint64_t operations,
+                   const std::string& allocator)
+    {
+        Result result;
+        result.name = workload.name;
+        result.allocator = allocator;
+        result.nanosPerOp = time(workload, operations);
+        result.allocationsPerOp = static_cast<double>(trace.allocations) / traced;
+
+        double allocatorNanos = std::max(replay(trace, rounds(operations, traced)) - trace.replayOverhead, 0.0);
+        result.allocatorNanosPerOp = allocatorNanos / traced;
+        result.allocatorNanosPerCall = trace.events.empty() ? 0 : allocatorNanos / trace.events.size();
+        return result;
+    }
+
+    void printJson(const std::vector<Result>& results, const RedisAllocatorMetrics& pool, size_t trimmed)
+    {
+        std::printf("{\n  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            double share = r.nanosPerOp > 0 ? std::min(r.allocatorNanosPerOp / r.nanosPerOp, 1.0) : 0;
+            std::printf("    {\"name\": \"%s\", \"allocator\": \"%s\", \"ns_per_op\": %.1f, "
+                        "\"allocations_per_op\": %.1f, \"allocator_ns_per_op\": %.1f, \"allocator_ns_per_call\": %.1f, "
+                        "\"allocator_share\": %.3f}%s\n",
+                        r.name.c_str(), r.allocator.c_str(), r.nanosPerOp, r.allocationsPerOp,
+                        r.allocatorNanosPerOp, r.allocatorNanosPerCall, share, i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ],\n  \"pool\": {\"allocations\": %llu, \"frees\": %llu, \"live_bytes\": %zu, "
+                    "\"reserved_bytes\": %zu, \"trimmed_bytes\": %zu, \"allocations_per_sec\": %.1f}\n}\n",
+                    static_cast<unsigned long long>(pool.allocations), static_cast<unsigned long long>(pool.frees),
+                    pool.liveBytes, pool.reservedBytes, trimmed, pool.allocationsPerSecond);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t operations = 200000;
+    if (argc > 1) {
+        operations = std::strtoull(argv[1], nullptr, 10);
+    }
+    constexpr int traced = 100;
+
+    // Workloads are rebuilt for every allocator, what one allocated is freed by the same one
+    std::vector<Trace> traces;
+    for (const Workload& workload : workloads()) {
+        traces.push_back(record(workload, traced));
+        measureOverhead(traces.back(), rounds(operations, traced));
+    }
+
+    std::vector<Result> results;
+    {
+        std::vector<Workload> all = workloads();
+        for (size_t i = 0; i < all.size(); ++i) {
+            results.push_back(measure(all[i], traces[i], traced, operations, "malloc"));
+        }
+    }
+    RedisClient::usePooledAllocator();
+    {
+        std::vector<Workload> all = workloads();
+        for (size_t i = 0; i < all.size(); ++i) {
+            results.push_back(measure(all[i], traces[i], traced, operations, "pool"));
+        }
+    }
+
+    // Workloads are gone, so every slab is free once this thread's cache is handed back
+    RedisAllocatorMetrics pool = RedisClient::getAllocatorMetrics();
+    printJson(results, pool, RedisClient::trimAllocator());
+    return 0;
+}
@@ -0,0 +1,157 @@
+// System Includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+
+// Throughput of the hiredis RESP reader on its own, no sockets involved.
+//
+// Usage: redisclient_reader_bench [megabytes]
+//
+// Each reply shape is fed to the reader in socket sized chunks, draining replies after
+// every chunk the way redisBufferRead() does. Doubles come twice, once short enough
+// for the exact fast conversion and once with 17 digits, which always goes through
+// strtod(). Results are printed to stdout as one JSON document with GB/s per shape.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t chunkSize = 16 * 1024;
+
+    struct Shape
+    {
+        std::string name;
+        std::string stream;     // Whole replies back to back
+        size_t replies = 0;
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t bytes = 0;
+        uint64_t replies = 0;
+        double gigabytesPerSecond = 0;
+    };
+
+    std::string bulk(const std::string& value)
+    {
+        return "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+    }
+
+    // Repeats one encoded reply until the stream is about the requested size
+    Shape repeated(const std::string& name, const std::string& reply, size_t target)
+    {
+        Shape shape;
+        shape.name = name;
+        shape.replies = std::max<size_t>(1, target / reply.size());
+        shape.stream.reserve(shape.replies * reply.size());
+        for (size_t i = 0; i < shape.replies; ++i) {
+            shape.stream += reply;
+        }
+        return shape;
+    }
+
+    std::vector<Shape> shapes(size_t target)
+    {
+        std::vector<Shape> result;
+
+        result.push_back(repeated("bulk_string_64b", bulk(std::string(64, 'v')), target));
+        result.push_back(repeated("bulk_string_4kb", bulk(std::string(4096, 'v')), target));
+
+        std::string array = "*1000\r\n";
+        for (int i = 0; i < 1000; ++i) {
+            array += bulk("value:" + std::to_string(100000 + i));
+        }
+        result.push_back(repeated("array_1000_bulk", array, target));
+
+        std::string integers = "*1000\r\n";
+        for (int i = 0; i < 1000; ++i) {
+            integers += ":" + std::to_string(1234567LL * i) + "\r\n";
+        }
+        result.push_back(repeated("array_1000_integer", integers, target));
+
+        std::string doubles = "*1000\r\n";
+        for (int i = 0; i < 1000; ++i) {
+            doubles += "," + std::to_string(i) + "." + std::to_string(1000 + i) + "\r\n";
+        }
+        result.push_back(repeated("array_1000_double", doubles, target));
+
+        std::string precise = "*1000\r\n";
+        for (int i = 0; i < 1000; ++i) {
+            precise += "," + std::to_string(i) + "." + std::to_string(1000000000000000LL + i) + "\r\n";
+        }
+        result.push_back(repeated("array_1000_double_17_digits", precise, target));
+
+        std::string message = "*3\r\n" + bulk("message") + bulk("sensor:floor2:temperature") +
+                              bulk("{\"celsius\":21.5,\"sequence\":184467}");
+        result.push_back(repeated("pubsub_message", message, target));
+        return result;
+    }
+
+    Result run(const Shape& shape)
+    {
+        redisReader* reader = redisReaderCreate();
+        Result result;
+        result.name = shape.name;
+
+        // One warm up pass, then the timed one
+        for (int pass = 0; pass < 2; ++pass) {
+            uint64_t replies = 0;
+            auto begin = Clock::now();
+            for (size_t offset = 0; offset < shape.stream.size(); offset += chunkSize) {
+                size_t length = std::min(chunkSize, shape.stream.size() - offset);
+                redisReaderFeed(reader, shape.stream.data() + offset, length);
+                void* reply = nullptr;
+                while (redisReaderGetReply(reader, &reply) == REDIS_OK && reply != nullptr) {
+                    freeReplyObject(reply);
+                    ++replies;
+                }
+                if (reader->err) {
+                    std::fprintf(stderr, "%s: %s\n", shape.name.c_str(), reader->errstr);
+                    std::exit(1);
+                }
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+            result.bytes = shape.stream.size();
+            result.replies = replies;
+            result.gigabytesPerSecond = seconds > 0 ? shape.stream.size() / seconds / 1e9 : 0;
+        }
+        redisReaderFree(reader);
+        return result;
+    }
+
+    void printJson(const std::vector<Result>& results)
+    {
+        std::printf("{\n  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::printf("    {\"name\": \"%s\", \"bytes\": %llu, \"replies\": %llu, \"gb_per_sec\": %.3f}%s\n",
+                        r.name.c_str(), static_cast<unsigned long long>(r.bytes),
+                        static_cast<unsigned long long>(r.replies), r.gigabytesPerSecond,
+                        i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = 64;
+    if (argc > 1) {
+        megabytes = std::strtoull(argv[1], nullptr, 10);
+    }
+
+    std::vector<Result> results;
+    for (const Shape& shape : shapes(megabytes * 1024 * 1024)) {
+        results.push_back(run(shape));
+    }
+    printJson(results);
+    return 0;
+}
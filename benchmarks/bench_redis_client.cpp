@@ -0,0 +1,295 @@
+// System Includes
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+#include "redisClient.h"
+#include "redisMockServer.h"
+
+// Microbenchmarks for the public RedisClient API.
+//
+// Usage: redisclient_bench [ops]
+//        redisclient_bench host port [ops]
+//
+// With no host a RedisMockServer is started in-process, so the numbers measure the
+// client rather than Redis. Results are printed to stdout as one JSON document with
+// ops/s and p50/p99/p999 latency in nanoseconds per benchmark.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t nowNanos()
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    struct Result
+    {
+        std::string name;
+        uint64_t operations = 0;
+        double opsPerSecond = 0;
+        uint64_t p50 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+    };
+
+    uint64_t percentile(std::vector<uint64_t>& samples, double fraction)
+    {
+        size_t rank = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    Result summarize(const std::string& name, std::vector<uint64_t> samples, uint64_t operations, uint64_t elapsedNanos)
+    {
+        Result result;
+        result.name = name;
+        result.operations = operations;
+        result.opsPerSecond = elapsedNanos ? operations * 1e9 / elapsedNanos : 0;
+        if (!samples.empty()) {
+            result.p50 = percentile(samples, 0.50);
+            result.p99 = percentile(samples, 0.99);
+            result.p999 = percentile(samples, 0.999);
+        }
+        return result;
+    }
+
+    // Times every operation on its own, for anything that does a round trip
+    Result measure(const std::string& name, uint64_t operations, const std::function<void(uint64_t)>& operation)
+    {
+        std::vector<uint64_t> samples;
+        samples.reserve(operations);
+
+        uint64_t begin = nowNanos();
+        for (uint64_t i = 0; i < operations; ++i) {
+            uint64_t start = nowNanos();
+            operation(i);
+            samples.push_back(nowNanos() - start);
+        }
+        return summarize(name, std::move(samples), operations, nowNanos() - begin);
+    }
+
+    // Splits the operations over threads calling at once, every operation timed on its own
+    Result measureConcurrent(const std::string& name, size_t threads, uint64_t operations,
+                             const std::function<void(uint64_t)>& operation)
+    {
+        std::vector<std::vector<uint64_t>> perThread(threads);
+        std::vector<std::thread> workers;
+
+        uint64_t begin = nowNanos();
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                std::vector<uint64_t>& samples = perThread[t];
+                samples.reserve(operations / threads + 1);
+                for (uint64_t i = t; i < operations; i += threads) {
+                    uint64_t start = nowNanos();
+                    operation(i);
+                    samples.push_back(nowNanos() - start);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        uint64_t elapsed = nowNanos() - begin;
+
+        std::vector<uint64_t> samples;
+        for (const std::vector<uint64_t>& part : perThread) {
+            samples.insert(samples.end(), part.begin(), part.end());
+        }
+        return summarize(name, std::move(samples), operations, elapsed);
+    }
+
+    // Times batches of operations, for work too short to time one call at a time
+    Result measureBatched(const std::string& name, uint64_t operations, const std::function<void(uint64_t)>& operation)
+    {
+        constexpr uint64_t batch = 100;
+        std::vector<uint64_t> samples;
+        samples.reserve(operations / batch + 1);
+
+        uint64_t begin = nowNanos();
+        for (uint64_t done = 0; done < operations; done += batch) {
+            uint64_t start = nowNanos();
+            for (uint64_t i = done; i < done + batch; ++i) {
+                operation(i);
+            }
+            samples.push_back((nowNanos() - start) / batch);
+        }
+        uint64_t performed = (operations + batch - 1) / batch * batch;
+        return summarize(name, std::move(samples), performed, nowNanos() - begin);
+    }
+
+    Result subscriberLatency(const std::string& host, int port, uint64_t operations)
+    {
+        std::vector<uint64_t> samples(operations);
+        std::atomic<uint64_t> received{0};
+
+        RedisClient subscriberClient(host, port);
+        subscriberClient.setSubscriberMode(SubscriberMode::EventLoop);
+        subscriberClient.setSubscriberChanels({"bench:latency"});
+        subscriberClient.setSubscriberViewCallback([&](const RedisMessageView& message) {
+            uint64_t sent = 0;
+            std::from_chars(message.payload.data(), message.payload.data() + message.payload.size(), sent);
+            uint64_t index = received.load(std::memory_order_relaxed);
+            if (index < samples.size()) {
+                samples[index] = nowNanos() - sent;
+            }
+            received.store(index + 1, std::memory_order_release);
+        });
+        subscriberClient.startSubscriber();
+
+        // Wait for the subscription to be live before publishing
+        RedisClient publisherClient(host, port);
+        for (int attempt = 0; attempt < 200; ++attempt) {
+            RedisReplyPtr reply(publisherClient.command("PUBLISH", "bench:latency", "0"));
+            if (reply && reply->type == REDIS_REPLY_INTEGER && reply->integer > 0) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        received.store(0);
+
+        // One message in flight at a time, so each sample is a delivery and not the
+        // time spent behind earlier messages in the publish queue
+        uint64_t begin = nowNanos();
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        for (uint64_t i = 0; i < operations && Clock::now() < deadline; ++i) {
+            publisherClient.publish("bench:latency", std::to_string(nowNanos()));
+            while (received.load(std::memory_order_acquire) <= i && Clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+        }
+        uint64_t elapsed = nowNanos() - begin;
+        subscriberClient.stopSubscriber();
+
+        uint64_t delivered = std::min<uint64_t>(received.load(), operations);
+        if (delivered < operations) {
+            spdlog::warn("Subscriber received {} of {} messages", delivered, operations);
+        }
+        samples.resize(delivered);
+        return summarize("subscriber_delivery", std::move(samples), delivered, elapsed);
+    }
+
+    void printJson(const std::string& server, const std::vector<Result>& results)
+    {
+        std::printf("{\n  \"server\": \"%s\",\n  \"benchmarks\": [\n", server.c_str());
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::printf("    {\"name\": \"%s\", \"ops\": %llu, \"ops_per_sec\": %.1f, "
+                        "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu}%s\n",
+                        r.name.c_str(), static_cast<unsigned long long>(r.operations), r.opsPerSecond,
+                        static_cast<unsigned long long>(r.p50), static_cast<unsigned long long>(r.p99),
+                        static_cast<unsigned long long>(r.p999), i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::unique_ptr<RedisMockServer> loopback;
+    std::string host_name = "127.0.0.1";
+    int address_port = 0;
+    if (argc > 2) {
+        host_name = argv[1];
+        address_port = std::atoi(argv[2]);
+    } else {
+        loopback = std::make_unique<RedisMockServer>();
+        address_port = loopback->port();
+    }
+    uint64_t operations = 20000;
+    if (argc == 2 || argc > 3) {
+        operations = std::strtoull(argv[argc == 2 ? 1 : 3], nullptr, 10);
+    }
+
+    std::vector<Result> results;
+    {
+        RedisClient client(host_name, address_port);
+        freeReplyObject(client.command("SET", "bench:button", "ON"));
+
+        results.push_back(measure("execute_command", operations, [&](uint64_t) {
+            freeReplyObject(client.executeCommand("SET bench:key value"));
+        }));
+        // Only the enqueue is timed, the queue is drained before the next benchmark
+        results.push_back(measure("publish", operations, [&](uint64_t) {
+            client.publish("bench:channel", "Tiger:Eats:Fruit");
+        }));
+        if (!client.flushPublishes(std::chrono::seconds(10))) {
+            spdlog::warn("Publish queue did not drain");
+        }
+        results.push_back(measure("set_and_publish_sequential", operations, [&](uint64_t) {
+            client.setAndPublish("bench:channel", "Tiger:Eats:Fruit", PublishMode::Sequential);
+        }));
+        results.push_back(measure("set_and_publish_pipelined", operations, [&](uint64_t) {
+            client.setAndPublish("bench:channel", "Tiger:Eats:Fruit", PublishMode::Pipelined);
+        }));
+        results.push_back(measure("set_and_publish_transaction", operations, [&](uint64_t) {
+            client.setAndPublish("bench:channel", "Tiger:Eats:Fruit", PublishMode::Transaction);
+        }));
+        results.push_back(measure("get_button_state", operations, [&](uint64_t) {
+            client.getButtonState("bench:button");
+        }));
+    }
+
+    // Sixteen threads sharing one client, a connection each against one coalescing connection
+    {
+        constexpr size_t threads = 16;
+        RedisClient pooled(host_name, address_port);
+        pooled.enableConnectionPool(RedisPoolConfig{threads});
+        results.push_back(measureConcurrent("execute_command_pool_16_threads", threads, operations, [&](uint64_t) {
+            freeReplyObject(pooled.command("SET", "bench:key", "value"));
+        }));
+
+        RedisClient pipelined(host_name, address_port);
+        pipelined.enableAutoPipelining();
+        results.push_back(measureConcurrent("execute_command_auto_pipeline_16_threads", threads, operations, [&](uint64_t) {
+            freeReplyObject(pipelined.command("SET", "bench:key", "value"));
+        }));
+    }
+
+    results.push_back(subscriberLatency(host_name, address_port, operations));
+
+    // splitString is private, it is a thin copy over RedisTokenRange which is timed here
+    const std::vector<std::string> parts = {"Tiger", "Eats", "Fruit", "Daily"};
+    std::vector<std::string> tokens;
+    results.push_back(measureBatched("split_string", operations * 10, [&](uint64_t) {
+        tokens.clear();
+        for (std::string_view token : RedisTokenRange("Tiger:Eats:Fruit:Daily")) {
+            tokens.emplace_back(token);
+        }
+    }));
+    std::string joined;
+    results.push_back(measureBatched("join_strings", operations * 10, [&](uint64_t) {
+        joined = RedisClient::joinStrings(parts, ":");
+    }));
+
+    // A 100 element array of short bulk strings, parsed the way replies come off the socket
+    std::string arrayReply = "*100\r\n";
+    for (int i = 0; i < 100; ++i) {
+        arrayReply += "$8\r\nvalue" + std::to_string(100 + i) + "\r\n";
+    }
+    redisReader* reader = redisReaderCreate();
+    results.push_back(measureBatched("reply_parse_array100", operations, [&](uint64_t) {
+        void* reply = nullptr;
+        redisReaderFeed(reader, arrayReply.data(), arrayReply.size());
+        redisReaderGetReply(reader, &reply);
+        freeReplyObject(reply);
+    }));
+    redisReaderFree(reader);
+
+    printJson(loopback ? "loopback" : host_name + ":" + std::to_string(address_port), results);
+    return 0;
+}
@@ -0,0 +1,132 @@
+// System Includes
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+#include "redisMockServer.h"
+#include "redisUringTransport.h"
+
+// net.h has no C++ linkage guards of its own
+extern "C" {
+#include <net.h>
+}
+
+// Compares the plain socket transport with the io_uring transport.
+//
+// Usage: redisclient_uring_bench [host port [ops]]
+//
+// With no host a RedisMockServer is started in-process. Exits 1 when the server cannot
+// be reached or a reply is wrong, and 77, the usual skip code, when the kernel has no
+// io_uring and only the socket path could be measured.
+//
+// Every read or write of the socket path is exactly one recv/send system call, so
+// the socket path is measured by counting calls through a wrapping redisContextFuncs.
+// The io_uring path reports its own io_uring_enter count.
+
+namespace
+{
+    uint64_t socketCalls = 0;
+    redisContextFuncs countingFuncs;
+
+    ssize_t countingRead(redisContext* context, char* buf, size_t bufcap)
+    {
+        ++socketCalls;
+        return redisNetRead(context, buf, bufcap);
+    }
+
+    ssize_t countingWrite(redisContext* context)
+    {
+        ++socketCalls;
+        return redisNetWrite(context);
+    }
+
+    struct Result
+    {
+        double opsPerSecond;
+        double syscallsPerOp;
+    };
+
+    // Round trips of single commands, then pipelined batches
+    Result run(redisContext* context, int operations, int batch, const std::function<uint64_t()>& syscalls)
+    {
+        uint64_t start = syscalls();
+        auto begin = std::chrono::steady_clock::now();
+
+        for (int done = 0; done < operations; done += batch) {
+            for (int i = 0; i < batch; ++i) {
+                redisAppendCommand(context, "SET bench:%d %d", i, done);
+            }
+            for (int i = 0; i < batch; ++i) {
+                redisReply* reply = nullptr;
+                if (redisGetReply(context, reinterpret_cast<void**>(&reply)) != REDIS_OK) {
+                    spdlog::error("Benchmark failed: {}", context->errstr);
+                    std::exit(1);
+                }
+                if (reply->type != REDIS_REPLY_STATUS) {
+                    spdlog::error("Benchmark failed: unexpected reply type {}", reply->type);
+                    std::exit(1);
+                }
+                freeReplyObject(reply);
+            }
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        return {operations / elapsed.count(), static_cast<double>(syscalls() - start) / operations};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::unique_ptr<RedisMockServer> loopback;
+    std::string host_name = "127.0.0.1";
+    int address_port = 0;
+    if (argc > 2) {
+        host_name = argv[1];
+        address_port = std::atoi(argv[2]);
+    } else {
+        loopback = std::make_unique<RedisMockServer>();
+        address_port = loopback->port();
+    }
+    int operations = argc > 3 ? std::atoi(argv[3]) : 100000;
+
+    redisContext* plain = redisConnect(host_name.c_str(), address_port);
+    redisContext* uring = redisConnect(host_name.c_str(), address_port);
+    if (plain == nullptr || plain->err || uring == nullptr || uring->err) {
+        spdlog::error("Could not connect to {}:{}", host_name, address_port);
+        return 1;
+    }
+
+    countingFuncs = *plain->funcs;
+    countingFuncs.read = &countingRead;
+    countingFuncs.write = &countingWrite;
+    plain->funcs = &countingFuncs;
+
+    RedisUringTransport transport(1);
+    if (transport.isAvailable() && !transport.install(uring)) {
+        spdlog::error("Could not install the io_uring transport");
+        return 1;
+    }
+    if (!transport.isAvailable()) {
+        spdlog::warn("io_uring is not available, only the socket path is measured");
+    }
+
+    for (int batch : {1, 16, 256}) {
+        Result socketPath = run(plain, operations, batch, []() { return socketCalls; });
+        spdlog::info("socket   batch={:<4} {:>10.0f} ops/s {:>6.3f} syscalls/op",
+                     batch, socketPath.opsPerSecond, socketPath.syscallsPerOp);
+
+        if (transport.isAvailable()) {
+            Result uringPath = run(uring, operations, batch, [&transport]() { return transport.stats().enters; });
+            spdlog::info("io_uring batch={:<4} {:>10.0f} ops/s {:>6.3f} syscalls/op",
+                         batch, uringPath.opsPerSecond, uringPath.syscallsPerOp);
+        }
+    }
+
+    redisFree(plain);
+    redisFree(uring);
+    return transport.isAvailable() ? 0 : 77;
+}
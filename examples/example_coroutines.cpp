@@ -0,0 +1,45 @@
+// System Includes
+#include <chrono>
+#include <future>
+#include <optional>
+#include <string>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+#include "redisAwait.h"
+
+// Reads a value and publishes it, each co_await suspends until Redis replies.
+// Builds as C++20, the client library itself stays C++17.
+RedisTask copyToChannel(RedisAwaitClient redis, std::promise<void>& done)
+{
+    try {
+        // Continue on the event loop thread, commands are sent from there without a hand over
+        co_await redis.schedule();
+
+        co_await redis.set("Tiger", "Eats:Fruit");
+        std::optional<std::string> value = co_await redis.get("Tiger");
+        if (value) {
+            long long receivers = co_await redis.publish("Tiger", *value);
+            spdlog::info("Published {} to {} subscribers", *value, receivers);
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Redis command failed: {}", e.what());
+    }
+    done.set_value();
+}
+
+int main(int argc, char** argv)
+{
+    std::string host_name = "localhost";
+    int address_port = 6379;
+
+    // Create the Redis Client
+    RedisClient client(host_name, address_port);
+
+    // The coroutine runs on the client's event loop, wait for it to finish
+    std::promise<void> done;
+    copyToChannel(RedisAwaitClient(client), done);
+    done.get_future().wait_for(std::chrono::seconds(5));
+
+    return 0;
+};
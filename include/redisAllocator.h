@@ -0,0 +1,55 @@
+#ifndef REDIS_ALLOCATOR_H
+#define REDIS_ALLOCATOR_H
+
+// System Includes
+#include <cstddef>
+#include <cstdint>
+
+struct RedisAllocatorConfig
+{
+    size_t threadCacheBlocks = 512;     // Free blocks a thread keeps per size class, half go back past that
+    size_t slabSize = 64 * 1024;        // Bytes taken from malloc at a time to carve blocks from
+};
+
+struct RedisAllocatorMetrics
+{
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    size_t liveBytes = 0;               // Usable bytes handed to hiredis and not yet freed
+    size_t reservedBytes = 0;           // Slab memory taken from malloc, kept until trim()
+    double allocationsPerSecond = 0;    // Averaged since the allocator was installed
+};
+
+// Pooled allocator for everything hiredis allocates: replies, reader tasks, sds strings,
+// formatted commands and async callbacks.
+//
+// Requests of up to 2 KiB are rounded to one of a few size classes and served from
+// per-thread free lists, carved out of larger slabs, with no lock on the common path.
+// A thread freeing more than it allocates, like a caller freeing replies built on an
+// I/O thread, hands surplus blocks to shared per-class lists that other threads refill
+// from. Larger requests go straight to malloc.
+//
+// hiredis has one allocator per process, so this is chosen once at startup before any
+// connection or reply exists: a block freed by a different allocator than the one that
+// made it is undefined behaviour. Once installed it stays for the life of the process.
+//
+// Slabs are not handed back to malloc as blocks are freed, reserved memory stays at the
+// high water mark of the busiest burst until trim() is called.
+class RedisAllocator
+{
+
+public:
+
+    // Installs the pooled allocator into hiredis, a second call is ignored. Throws when
+    // hiredis already uses some other allocator
+    static void install(RedisAllocatorConfig config = RedisAllocatorConfig());
+    static bool installed();
+
+    // Hands the calling thread's cached blocks back, then returns to malloc every slab
+    // with no block in use or cached by another thread. Returns the bytes released
+    static size_t trim();
+    static RedisAllocatorMetrics metrics();
+
+};
+
+#endif // REDIS_ALLOCATOR_H
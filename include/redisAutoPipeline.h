@@ -0,0 +1,119 @@
+#ifndef REDIS_AUTO_PIPELINE_H
+#define REDIS_AUTO_PIPELINE_H
+
+// System Includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisBoundedQueue.h"
+#include "redisReconnect.h"
+
+struct RedisAutoPipelineConfig
+{
+    size_t queueCapacity = 65536;   // Rounded up to a power of two, a full queue rejects new commands
+    size_t maxBatch = 4096;         // Queued commands drained into one write
+};
+
+struct RedisAutoPipelineMetrics
+{
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t failed = 0;            // Commands whose connection was lost before the reply
+    uint64_t rejected = 0;          // Commands refused because the queue was full
+    uint64_t flushes = 0;           // Writes, each carrying every command queued since the last
+    size_t queueDepth = 0;
+};
+
+// One connection shared by any number of calling threads, with their commands
+// coalesced into pipelines.
+//
+// Callers push their RESP encoded command into a lock-free queue and block until the
+// reply arrives. A single I/O thread owns the connection: it appends everything queued
+// since its last write, writes it out at once, and hands replies back in order to the
+// callers waiting on them. The more threads call at once the larger the batches get,
+// so throughput grows with concurrency instead of every caller paying a round trip.
+class RedisAutoPipeline
+{
+
+public:
+
+    RedisAutoPipeline(const RedisEndpoint& address, RedisAutoPipelineConfig config = RedisAutoPipelineConfig(),
+                      RedisReconnectConfig reconnect = RedisReconnectConfig());
+    ~RedisAutoPipeline();
+
+    RedisAutoPipeline(const RedisAutoPipeline&) = delete;
+    RedisAutoPipeline& operator=(const RedisAutoPipeline&) = delete;
+
+    // Sends a RESP encoded command and waits for its reply, from any thread. The reply
+    // is the caller's to free, a full queue or a lost connection throws
+    redisReply* execute(std::string_view formatted);
+
+    // Sends several RESP encoded commands back to back, nothing other callers queue can
+    // come between them, and waits for the reply to the last. The others are discarded
+    redisReply* execute(std::string_view formatted, size_t commands);
+
+    // Moves the connection to another server once the replies in flight are read
+    void moveTo(const RedisEndpoint& endpoint);
+
+    RedisAutoPipelineMetrics metrics() const;
+    RedisReconnectMetrics reconnectMetrics() const;
+
+private:
+    // Lives on the calling thread's stack for as long as its command is in flight
+    struct Waiter
+    {
+        std::mutex mutex;
+        std::condition_variable answered;
+        bool finished = false;
+        redisReply* reply = nullptr;
+        std::string error;
+    };
+
+    // Command bytes stay with the waiting caller, only the view is queued
+    struct Request
+    {
+        const char* data = nullptr;
+        size_t length = 0;
+        Waiter* waiter = nullptr;
+        size_t commands = 1;
+    };
+
+    const RedisAutoPipelineConfig config;
+    redisContext* context = nullptr;
+    RedisBoundedQueue<Request> queue;
+    std::unique_ptr<RedisReconnector> reconnector;
+
+    std::thread ioThread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> sleeping{false};
+    int wakeFd = -1;
+
+    std::mutex targetMutex;
+    RedisEndpoint target;
+    std::atomic<uint64_t> targetGeneration{0};
+
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> flushes{0};
+
+    void ioLoop();
+    void wake();
+    // Waits for a wake up or, when fd is set, a readable socket, true for the latter.
+    // Returns straight away when queued is set and commands are already waiting
+    bool idle(int fd, bool queued);
+    bool restore(uint64_t& generation);
+    static void complete(Waiter* waiter, redisReply* reply, const char* error);
+
+};
+
+#endif // REDIS_AUTO_PIPELINE_H
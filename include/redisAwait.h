@@ -0,0 +1,187 @@
+#ifndef REDIS_AWAIT_H
+#define REDIS_AWAIT_H
+
+// Awaitable commands for C++20 callers. The library itself builds as C++17, this
+// header only provides its types when the including translation unit has coroutines.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+// System Includes
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+#include "redisClient.h"
+#include "redisDecode.h"
+
+// One command awaited by a coroutine, decoding its reply into a T.
+//
+// The awaiter lives in the awaiting coroutine's frame and is itself the completion
+// hiredis calls back, so sending and resuming allocate nothing beyond hiredis' own
+// callback entry. The coroutine resumes on the event loop thread. Arguments are only
+// viewed, await the command in the expression that creates it.
+template <typename T, size_t N>
+class RedisCommandAwaiter : private RedisAsyncCompletion
+{
+
+public:
+
+    template <typename... Args>
+    explicit RedisCommandAwaiter(RedisClient& client, const Args&... args) : client(client)
+    {
+        static_assert(sizeof...(Args) == N, "One view per command argument");
+        size_t index = 0;
+        ((argv[index] = std::string_view(args).data(), argvlen[index] = std::string_view(args).size(), ++index), ...);
+        complete = &RedisCommandAwaiter::onReply;
+    }
+
+    RedisCommandAwaiter(const RedisCommandAwaiter&) = delete;
+    RedisCommandAwaiter& operator=(const RedisCommandAwaiter&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        waiting = handle;
+        client.sendAsync(static_cast<int>(N), argv.data(), argvlen.data(), this);
+    }
+
+    T await_resume()
+    {
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+        return std::move(value);
+    }
+
+private:
+    RedisClient& client;
+    std::array<const char*, N> argv{};
+    std::array<size_t, N> argvlen{};
+    std::coroutine_handle<> waiting;
+    T value{};
+    std::exception_ptr failure;
+
+    static void onReply(RedisAsyncCompletion* completion, redisReply* reply)
+    {
+        RedisCommandAwaiter* awaiter = static_cast<RedisCommandAwaiter*>(completion);
+        try {
+            if (reply == nullptr) {
+                throw std::runtime_error("Redis connection lost before the reply arrived");
+            }
+            RedisDecoder<T> decoder(awaiter->value);
+            decoder.decode(reply);
+            decoder.check();
+        } catch (...) {
+            awaiter->failure = std::current_exception();
+        }
+        awaiter->waiting.resume();
+    }
+
+};
+
+// Moves the awaiting coroutine onto the client's event loop thread, where awaited
+// commands are sent without a hand over
+class RedisScheduleAwaiter
+{
+
+public:
+
+    explicit RedisScheduleAwaiter(RedisClient& client) : events(client.eventLoop()) {}
+
+    bool await_ready() const { return events.inLoopThread(); }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        events.post([handle]() { handle.resume(); });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    RedisEventLoop& events;
+
+};
+
+// Coroutine type for fire and forget work on the event loop. Starts straight away and
+// frees itself when done, an escaping exception is logged.
+struct RedisTask
+{
+    struct promise_type
+    {
+        RedisTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept
+        {
+            try {
+                throw;
+            } catch (const std::exception& e) {
+                spdlog::error("Redis coroutine failed: {}", e.what());
+            } catch (...) {
+                spdlog::error("Redis coroutine failed");
+            }
+        }
+    };
+};
+
+// Awaitable view of a RedisClient:
+//
+//     RedisTask run(RedisAwaitClient redis)
+//     {
+//         co_await redis.schedule();
+//         std::optional<std::string> value = co_await redis.get("key");
+//         long long receivers = co_await redis.publish("channel", *value);
+//     }
+//
+// Commands go out on the client's async connection and complete in order.
+class RedisAwaitClient
+{
+
+public:
+
+    explicit RedisAwaitClient(RedisClient& client) : client(&client) {}
+
+    template <typename T, typename... Args>
+    RedisCommandAwaiter<T, sizeof...(Args)> command(const Args&... args)
+    {
+        return RedisCommandAwaiter<T, sizeof...(Args)>(*client, args...);
+    }
+
+    RedisCommandAwaiter<std::optional<std::string>, 2> get(std::string_view key)
+    {
+        return command<std::optional<std::string>>(std::string_view("GET"), key);
+    }
+
+    RedisCommandAwaiter<bool, 3> set(std::string_view key, std::string_view value)
+    {
+        return command<bool>(std::string_view("SET"), key, value);
+    }
+
+    // Resumes with the number of subscribers that received the message
+    RedisCommandAwaiter<long long, 3> publish(std::string_view channel, std::string_view message)
+    {
+        return command<long long>(std::string_view("PUBLISH"), channel, message);
+    }
+
+    RedisScheduleAwaiter schedule()
+    {
+        return RedisScheduleAwaiter(*client);
+    }
+
+private:
+    RedisClient* client;
+
+};
+
+#endif // __cpp_impl_coroutine
+
+#endif // REDIS_AWAIT_H
@@ -0,0 +1,134 @@
+#ifndef REDIS_BOUNDED_QUEUE_H
+#define REDIS_BOUNDED_QUEUE_H
+
+// System Includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bounded lock-free multi-producer multi-consumer queue (Vyukov's sequence ring).
+//
+// Each cell carries a sequence number that tells producers and consumers whether the
+// cell is free for the current lap, so push and pop only CAS a shared index and never
+// block. Capacity is rounded up to a power of two.
+template <typename T>
+class RedisBoundedQueue
+{
+
+public:
+
+    explicit RedisBoundedQueue(size_t capacity)
+        : mask(roundUp(capacity) - 1), cells(new Cell[mask + 1])
+    {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~RedisBoundedQueue()
+    {
+        T discarded;
+        while (tryPop(discarded)) {
+        }
+    }
+
+    RedisBoundedQueue(const RedisBoundedQueue&) = delete;
+    RedisBoundedQueue& operator=(const RedisBoundedQueue&) = delete;
+
+    // Returns false and leaves value untouched when the queue is full
+    bool tryPush(T&& value)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    new (&cell.storage) T(std::move(value));
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false when the queue is empty
+    bool tryPop(T& value)
+    {
+        size_t position = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    T* stored = reinterpret_cast<T*>(&cell.storage);
+                    value = std::move(*stored);
+                    stored->~T();
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate while producers and consumers are active
+    size_t size() const
+    {
+        size_t first = head.load(std::memory_order_relaxed);
+        size_t last = tail.load(std::memory_order_relaxed);
+        return last > first ? last - first : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    static size_t roundUp(size_t value)
+    {
+        if (value < 2) {
+            return 2;
+        }
+        size_t power = 1;
+        while (power < value) {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    // Producers and consumers on separate cache lines
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> head{0};
+
+};
+
+#endif // REDIS_BOUNDED_QUEUE_H
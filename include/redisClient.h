@@ -4,13 +4,95 @@
 // System Includes
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
 #include <vector>
 #include <functional>
+#include <mutex>
+#include <optional>
 
 // Project Includes
 #include <hiredis.h>
+#include "redisAllocator.h"
+#include "redisAutoPipeline.h"
+#include "redisBoundedQueue.h"
+#include "redisClientCache.h"
+#include "redisCluster.h"
+#include "redisCommand.h"
+#include "redisConnectionPool.h"
+#include "redisDecode.h"
+#include "redisDispatcher.h"
+#include "redisEventLoop.h"
+#include "redisLatency.h"
+#include "redisMessage.h"
+#include "redisPipeline.h"
+#include "redisReconnect.h"
+#include "redisReplyArena.h"
+#include "redisSentinel.h"
+#include "redisStream.h"
+#include "redisUringTransport.h"
+
+// How setAndPublish sends its PUBLISH and SET commands
+enum class PublishMode
+{
+    Sequential,   // Two blocking round trips
+    Pipelined,    // Both commands in one round trip
+    Transaction   // One round trip wrapped in MULTI/EXEC
+};
+
+// What a subscription name refers to
+enum class SubscriptionKind
+{
+    Channel,    // SUBSCRIBE, delivered as message
+    Pattern,    // PSUBSCRIBE, delivered as pmessage
+    Shard       // SSUBSCRIBE on Redis 7, delivered as smessage, Thread mode only
+};
+
+// Outcome of an asynchronous publish
+struct RedisPublishResult
+{
+    bool ok = false;
+    long long receivers = 0;        // Subscribers that received the message
+    std::string error;
+};
+
+// Called on the publisher thread once a queued publish has been answered
+using PublishCallback = std::function<void(const std::string& channel, const RedisPublishResult& result)>;
+
+struct RedisPublishConfig
+{
+    size_t queueCapacity = 65536;   // Rounded up to a power of two, full queues reject new publishes
+    size_t maxBatch = 1024;         // Publishes pipelined into one write
+};
+
+struct RedisPublishMetrics
+{
+    uint64_t queued = 0;
+    uint64_t published = 0;
+    uint64_t failed = 0;
+    uint64_t rejected = 0;          // Publishes refused because the queue was full
+    uint64_t batches = 0;
+    size_t queueDepth = 0;
+};
+
+// Completion of one command sent with sendAsync, embedded in whatever waits for the
+// reply so a command costs no allocation beyond hiredis' own callback entry. Runs on
+// the event loop thread, a null reply means the command was never answered
+struct RedisAsyncCompletion
+{
+    void (*complete)(RedisAsyncCompletion* completion, redisReply* reply) = nullptr;
+};
+
+// Where subscriber messages are read
+enum class SubscriberMode
+{
+    Thread,     // Dedicated thread blocking on redisGetReply
+    EventLoop   // Async context multiplexed on the client event loop
+};
 
 class RedisClient
 {
@@ -18,49 +100,349 @@ class RedisClient
 public:
 
     RedisClient(std::string host, int port);
+    // Connects to the master the Sentinels report and follows it through failovers
+    explicit RedisClient(RedisSentinelConfig config);
     ~RedisClient();
 
     // Context methods
     redisReply* executeCommand(std::string command) const;
+    redisReply* executeArgv(std::initializer_list<std::string_view> argv) const;
+    redisReply* executeArgv(const std::vector<std::string>& argv) const;
+    template <typename... Args>
+    redisReply* command(const Args&... args) const;
+    template <size_t Arity, typename... Args>
+    redisReply* command(const RedisCommand<Arity>& fixed, const Args&... args) const;
+    void consumeArgv(std::initializer_list<std::string_view> argv,
+                     const std::function<void(const redisReply*)>& consumer) const;
+    void consumeArgv(const std::vector<std::string>& argv,
+                     const std::function<void(const redisReply*)>& consumer) const;
+    // True when the key holds "ON". A missing key, or one holding anything but a string,
+    // is set to OFF, except through the client cache which throws on a non-string key
     bool getButtonState(std::string key) const;
 
-    // Publisher methods
+    // Typed methods, the reply is parsed straight into T without building a redisReply
+    // tree, error replies and type mismatches throw
+    template <typename T, typename... Args>
+    T get(const Args&... args) const;
+    template <typename T, size_t Arity, typename... Args>
+    T get(const RedisCommand<Arity>& fixed, const Args&... args) const;
+    template <typename T>
+    T getArgv(const std::vector<std::string>& argv) const;
+
+    // Streaming methods, every value of the reply goes to the visitor as it is read off
+    // the socket and no reply is built, so memory stays bounded by the socket buffer
+    // however many elements come back. Returns the number of elements of the reply.
+    // With cluster routing or auto pipelining the reply is built first and then visited
+    template <typename... Args>
+    size_t stream(const RedisElementVisitor& visitor, const Args&... args) const;
+    size_t streamArgv(const std::vector<std::string>& argv, const RedisElementVisitor& visitor) const;
+    // Batch on the publisher or a pooled connection, throws with cluster routing or auto
+    // pipelining
+    Pipeline pipeline();
+
+    // Routes the publisher connection through io_uring, false when the kernel lacks it.
+    // Only the publisher is covered, so it cannot be combined with the connection pool,
+    // auto pipelining or cluster routing, which never use the publisher for commands
+    bool enableUringTransport();
+
+    // Client side cache methods, once enabled getButtonState and cachedGet are served locally
+    void enableClientCache(RedisCacheConfig config = RedisCacheConfig());
+    RedisClientCache* clientCache() const;
+    std::optional<std::string> cachedGet(const std::string& key) const;
+
+    // Connection pool methods, once enabled commands from any thread use pooled connections
+    void enableConnectionPool(RedisPoolConfig config = RedisPoolConfig());
+    RedisConnectionPool* connectionPool() const;
+
+    // Auto pipelining methods, once enabled commands from every thread share one connection
+    // and are written out together, cluster routing still takes precedence
+    void enableAutoPipelining(RedisAutoPipelineConfig config = RedisAutoPipelineConfig());
+    RedisAutoPipeline* autoPipeline() const;
+
+    // Cluster methods, once enabled keyed commands go to the primary owning their slot
+    void enableCluster(RedisClusterConfig config = RedisClusterConfig());
+    RedisCluster* clusterClient() const;
+
+    // Sentinel methods, only set when the client was created from a RedisSentinelConfig
+    RedisSentinel* sentinelClient() const;
+
+    // Publisher methods, publish only queues the message and never waits on Redis
     void publish(const std::string& channel, const std::string& message);
-    void setAndPublish(const std::string& channel, const std::string& message);
+    void publish(const std::string& channel, const std::string& message, PublishCallback done);
+    void setPublishCallback(PublishCallback callback);
+    void setPublishQueue(RedisPublishConfig config);
+    bool flushPublishes(std::chrono::milliseconds timeout);
+    RedisPublishMetrics getPublishMetrics() const;
+    void setAndPublish(const std::string& channel, const std::string& message,
+                       PublishMode mode = PublishMode::Pipelined);
 
     // Subscriber methods
     void startSubscriber();
     void stopSubscriber();
     void setSubscriberCallback(std::function<void(std::vector<std::string>)> callback);
+    void setSubscriberViewCallback(std::function<void(const RedisMessageView&)> callback);
     void setSubscriberChanels(std::vector<std::string> channels);
     std::vector<std::string> getSubscriberChannels() const;
+    void setSubscriberPatterns(std::vector<std::string> patterns);
+    std::vector<std::string> getSubscriberPatterns() const;
+    void setSubscriberShardChannels(std::vector<std::string> channels);
+    std::vector<std::string> getSubscriberShardChannels() const;
+    // Applied straight away while the subscriber runs, without restarting it
+    void subscribe(const std::vector<std::string>& names, SubscriptionKind kind = SubscriptionKind::Channel);
+    void unsubscribe(const std::vector<std::string>& names, SubscriptionKind kind = SubscriptionKind::Channel);
+    void setSubscriberMode(SubscriberMode mode);
+    void setSubscriberDispatch(RedisDispatchConfig config);
+    RedisDispatchMetrics getDispatchMetrics() const;
+
+    // Latency methods, commands and subscriber messages are recorded unless turned off
+    void setLatencyTracking(bool enabled);
+    std::map<std::string, RedisLatencySnapshot> getLatencySnapshot() const;
+    void startLatencyDump(std::chrono::milliseconds interval);
+    void stopLatencyDump();
+
+    // Reconnect methods, lost connections are brought back with backoff instead of failing for good.
+    // Only queued publishes are replayed after a reconnect, a command whose connection is
+    // lost throws and is never sent again
+    void setReconnectPolicy(RedisReconnectConfig config);
+    RedisReconnectMetrics getReconnectMetrics() const;
+
+    // Allocator methods, the pooled hiredis allocator is chosen at startup before any
+    // client exists and is shared by every client in the process
+    static void usePooledAllocator(RedisAllocatorConfig config = RedisAllocatorConfig());
+    static RedisAllocatorMetrics getAllocatorMetrics();
+    static size_t trimAllocator();
+
+    // Event loop methods
+    RedisEventLoop& eventLoop();
+    redisAsyncContext* connectAsync();
+    // Sends on the client's async command connection, from the loop thread without any
+    // hand over. argv must stay valid until the completion runs
+    void sendAsync(int argc, const char** argv, const size_t* argvlen, RedisAsyncCompletion* completion);
 
     // Help methods
     static std::string joinStrings(const std::vector<std::string>& strings, const std::string& separator);
     bool getState(std::string value);
 
 private:
-    // member variables
+    RedisClient(const RedisEndpoint& address, std::unique_ptr<RedisSentinel> failover);
+
+    // member variables, with Sentinel the host and port are the master found at startup
     const std::string serverHost;
     const int serverPort;
     std::atomic<bool> subscriberRunning{false};
+
+    // Subscriptions restored on every (re)connect, and changes waiting for the subscriber thread
+    mutable std::mutex subscriptionMutex;
     std::vector<std::string> subscriberChannels;
+    std::vector<std::string> subscriberPatterns;
+    std::vector<std::string> subscriberShardChannels;
+    std::vector<std::vector<std::string>> subscriptionChanges;
+    int subscriberWakeFd = -1;
+
     std::function<void(std::vector<std::string>)> messageHandler;
+    std::function<void(const RedisMessageView&)> messageViewHandler;
+    SubscriberMode subscriberMode = SubscriberMode::Thread;
+    RedisDispatchConfig dispatchConfig;
+    std::unique_ptr<RedisMessageDispatcher> dispatcher;
 
     // Redis connection parameters
     std::shared_ptr<redisContext> publisher= nullptr;
     std::shared_ptr<redisContext> subscriber= nullptr;
 
+    // Reply arenas for replies consumed before the next command on each context
+    std::unique_ptr<RedisReplyArena> publisherArena;
+    std::unique_ptr<RedisReplyArena> subscriberArena;
+
+    // Optional pool used for commands instead of the publisher context
+    std::unique_ptr<RedisConnectionPool> pool;
+
+    // Optional auto pipelining used for commands instead of the pool or the publisher
+    std::unique_ptr<RedisAutoPipeline> autoPipelining;
+
+    // Optional cluster routing, the host and port are the seed node
+    std::unique_ptr<RedisCluster> cluster;
+
+    // Optional Sentinel failover, each connection owner compares the master generation
+    // it last connected to against the Sentinel's and reconnects when they differ
+    std::unique_ptr<RedisSentinel> sentinel;
+    mutable std::atomic<uint64_t> publisherGeneration{0};
+    mutable std::atomic<uint64_t> poolGeneration{0};
+    mutable std::atomic<uint64_t> autoPipelineGeneration{0};
+    std::atomic<uint64_t> subscriberGeneration{0};
+    std::atomic<uint64_t> queueGeneration{0};
+
+    // Replica connection for reads when Sentinel readFromReplicas is set, shared by
+    // every calling thread so it is used, and reconnected, by one at a time
+    std::shared_ptr<redisContext> replica = nullptr;
+    mutable std::mutex replicaMutex;
+
+    // Send-to-reply latency per command and receive-to-callback latency per message
+    std::unique_ptr<RedisLatencyRecorder> latency;
+    std::atomic<bool> latencyTracking{true};
+    size_t messageMetric = 0;
+
+    // Reconnect state of the publisher, subscriber and publish queue connections
+    RedisReconnectConfig reconnectConfig;
+    std::unique_ptr<RedisReconnector> publisherReconnect;
+    std::unique_ptr<RedisReconnector> subscriberReconnect;
+    std::unique_ptr<RedisReconnector> queueReconnect;
+    std::unique_ptr<RedisReconnector> replicaReconnect;
+    // Reconnecting the publisher replaces its socket and buffers, one caller at a time does it
+    mutable std::mutex publisherReconnectMutex;
+    size_t reconnectMetric = 0;
+
+    // Optional RESP3 tracking cache for GETs
+    std::unique_ptr<RedisClientCache> cache;
+
+    // Optional io_uring transport for the publisher context
+    std::unique_ptr<RedisUringTransport> transport;
+
+    // Event loop and the async contexts it drives, all owned by the client
+    std::unique_ptr<RedisEventLoop> loop;
+    std::once_flag loopOnce;
+    std::vector<redisAsyncContext*> asyncContexts;
+    redisAsyncContext* asyncSubscriber = nullptr;
+    redisAsyncContext* asyncCommands = nullptr;
+
+    // Queued publishes, drained by the publisher thread on its own connection
+    struct PendingPublish
+    {
+        std::string channel;
+        std::string message;
+        PublishCallback done;
+        std::chrono::steady_clock::time_point queued;
+    };
+    RedisPublishConfig publishConfig;
+    std::unique_ptr<RedisBoundedQueue<PendingPublish>> publishQueue;
+    std::shared_ptr<redisContext> publishContext = nullptr;
+    PublishCallback publishCallback;
+    std::once_flag publisherOnce;
+    std::atomic<bool> publisherRunning{false};
+    std::atomic<bool> publisherSleeping{false};
+    std::mutex publisherMutex;
+    std::condition_variable publisherWake;
+    std::condition_variable publishFlushed;
+    std::atomic<uint64_t> publishQueued{0};
+    std::atomic<uint64_t> publishCompleted{0};
+    std::atomic<uint64_t> publishFailed{0};
+    std::atomic<uint64_t> publishRejected{0};
+    std::atomic<uint64_t> publishBatches{0};
+    size_t publishMetric = 0;
+
     // Threads for subscriber and publisher
     std::thread subscriberThread;
     std::thread publisherThread;
 
     // Helper functions
     void connect();
+    RedisEndpoint serverAddress() const;
+    void createReconnectors();
+    bool masterMoved(std::atomic<uint64_t>& seen) const;
+    redisContext* replicaContext(std::unique_lock<std::mutex>& hold) const;
+    redisContext* commandContext(RedisConnectionPool::Lease& lease,
+                                 std::string_view key = std::string_view()) const;
+    template <typename Range>
+    redisReply* sendRange(const Range& argv, redisContext* context = nullptr) const;
+    redisReply* sendArgv(int argc, const char** argv, const size_t* argvlen,
+                         redisContext* context = nullptr) const;
+    redisReply* sendFormatted(const std::string& formatted, redisContext* context = nullptr) const;
+    redisReply* sendPipelined(std::string_view formatted, size_t commands = 1) const;
+    void decodeFormatted(const std::string& formatted, RedisDecodeSink& sink, bool read = false) const;
+    void consumeReply(const std::function<redisReply*(redisContext*)>& send,
+                      const std::function<void(const redisReply*)>& consumer) const;
     void disconnect();
+    void startPublisher();
+    void stopPublisher();
+    void publisherLoop();
+    void sendPublishBatch(std::vector<PendingPublish>& batch);
+    void completePublish(PendingPublish& pending, const RedisPublishResult& result,
+                         const PublishCallback& fallback);
+    bool reconnect(RedisReconnector& reconnector, redisContext* context, const std::atomic<bool>& running);
     void subscriberLoop();
+    void subscribeChannels();
+    void readMessages();
+    std::vector<std::string>& subscriptionList(SubscriptionKind kind);
+    void changeSubscriptions(const std::vector<std::string>& names, SubscriptionKind kind, bool add);
+    bool sendSubscriberCommands(const std::vector<std::vector<std::string>>& commands);
+    void wakeSubscriber();
+    static bool isMessage(const redisReply* reply);
+    void deliverMessage(redisReply* reply);
+    void recordCommand(std::string_view command, std::chrono::steady_clock::time_point start) const;
+    void recordMessage(std::chrono::steady_clock::time_point received) const;
+    void handleMessage(const redisReply* reply);
+    void startAsyncSubscriber();
+    void stopAsyncSubscriber();
+    static void onAsyncMessage(redisAsyncContext* context, void* reply, void* privdata);
+    static void onAsyncReply(redisAsyncContext* context, void* reply, void* privdata);
+    static void onAsyncDisconnect(const redisAsyncContext* context, int status);
     std::vector<std::string> splitString(const char* s);
 
 };
 
+// Binary safe command, each argument is sent as-is without format parsing
+template <typename... Args>
+redisReply* RedisClient::command(const Args&... args) const
+{
+    static_assert(sizeof...(Args) > 0, "A command needs at least its name");
+
+    const std::string_view views[] = {std::string_view(args)...};
+    const char* argv[sizeof...(Args)];
+    size_t argvlen[sizeof...(Args)];
+    for (size_t i = 0; i < sizeof...(Args); ++i) {
+        argv[i] = views[i].data();
+        argvlen[i] = views[i].size();
+    }
+
+    return sendArgv(static_cast<int>(sizeof...(Args)), argv, argvlen);
+}
+
+// Fixed command with a precomputed RESP header
+template <size_t Arity, typename... Args>
+redisReply* RedisClient::command(const RedisCommand<Arity>& fixed, const Args&... args) const
+{
+    return sendFormatted(RedisProtocol::formatCommand(fixed, args...));
+}
+
+// Typed command, e.g. get<int64_t>("INCR", key) or get<std::vector<std::string>>("LRANGE", key, "0", "-1")
+template <typename T, typename... Args>
+T RedisClient::get(const Args&... args) const
+{
+    T value{};
+    RedisDecoder<T> decoder(value);
+    decodeFormatted(RedisProtocol::formatArgs(args...), decoder);
+    return value;
+}
+
+// Typed fixed command with a precomputed RESP header
+template <typename T, size_t Arity, typename... Args>
+T RedisClient::get(const RedisCommand<Arity>& fixed, const Args&... args) const
+{
+    T value{};
+    RedisDecoder<T> decoder(value);
+    decodeFormatted(RedisProtocol::formatCommand(fixed, args...), decoder);
+    return value;
+}
+
+template <typename T>
+T RedisClient::getArgv(const std::vector<std::string>& argv) const
+{
+    if (argv.empty()) {
+        throw std::runtime_error("Empty command");
+    }
+    T value{};
+    RedisDecoder<T> decoder(value);
+    decodeFormatted(RedisProtocol::formatArgv(argv), decoder);
+    return value;
+}
+
+// Streamed command, e.g. stream(visitor, "LRANGE", key, "0", "-1")
+template <typename... Args>
+size_t RedisClient::stream(const RedisElementVisitor& visitor, const Args&... args) const
+{
+    RedisStreamSink sink(visitor);
+    decodeFormatted(RedisProtocol::formatArgs(args...), sink);
+    sink.rethrow();
+    return sink.elements();
+}
+
 #endif // REDIS_CLIENT_H
@@ -0,0 +1,107 @@
+#ifndef REDIS_CLIENT_CACHE_H
+#define REDIS_CLIENT_CACHE_H
+
+// System Includes
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+
+struct RedisCacheConfig
+{
+    size_t capacity = 4096;     // Keys held before the CLOCK hand starts evicting
+};
+
+struct RedisCacheMetrics
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0; // Keys dropped because the server reported a change
+    uint64_t flushes = 0;       // Whole cache dropped, after FLUSHALL or a lost connection
+    size_t size = 0;
+};
+
+// Client side cache of GET replies kept coherent by RESP3 CLIENT TRACKING.
+//
+// The cache owns a RESP3 connection with tracking turned on, so every key it reads is
+// remembered by the server and any later change is pushed back as an invalidate
+// message. Hits are served from memory without touching the network. Pushes are
+// picked up while a miss waits for its reply, and by a small thread that polls the
+// connection while it is otherwise idle. Eviction is CLOCK, a hit only sets the
+// entry's reference bit so lookups can share the lock.
+class RedisClientCache
+{
+
+public:
+
+    RedisClientCache(std::string host, int port, RedisCacheConfig config = RedisCacheConfig());
+    ~RedisClientCache();
+
+    RedisClientCache(const RedisClientCache&) = delete;
+    RedisClientCache& operator=(const RedisClientCache&) = delete;
+
+    // Value of the key, nullopt when it does not exist. Missing keys are cached too.
+    std::optional<std::string> get(const std::string& key);
+
+    // Drop one key or everything, the next get goes to the server
+    void invalidate(const std::string& key);
+    void clear();
+
+    size_t size() const;
+    RedisCacheMetrics metrics() const;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::optional<std::string> value;
+        std::atomic<bool> referenced{false};
+    };
+
+    const std::string serverHost;
+    const int serverPort;
+    const size_t capacity;
+
+    // Entries and the index are guarded by entryMutex, lookups only take it shared
+    mutable std::shared_mutex entryMutex;
+    std::unique_ptr<Entry[]> entries;
+    std::unordered_map<std::string, size_t> index;
+    std::vector<size_t> freeEntries;
+    size_t hand = 0;
+
+    // The tracking connection, guarded by contextMutex
+    std::mutex contextMutex;
+    redisContext* context = nullptr;
+    bool broken = false;
+
+    std::atomic<bool> running{true};
+    std::thread invalidationThread;
+
+    // Metrics
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> invalidations{0};
+    std::atomic<uint64_t> flushes{0};
+
+    bool lookup(const std::string& key, std::optional<std::string>& value);
+    void store(const std::string& key, const std::optional<std::string>& value);
+    void connect();
+    void markBroken();
+    void drainPushes();
+    void invalidationLoop();
+    static void onPush(void* privdata, void* reply);
+
+};
+
+#endif // REDIS_CLIENT_CACHE_H
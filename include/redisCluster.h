@@ -0,0 +1,130 @@
+#ifndef REDIS_CLUSTER_H
+#define REDIS_CLUSTER_H
+
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisConnectionPool.h"
+#include "redisReply.h"
+
+struct RedisClusterConfig
+{
+    RedisPoolConfig pool{4};                            // Connections per node
+    size_t maxRedirects = 5;                            // MOVED/ASK hops before the reply is returned as-is
+    std::chrono::milliseconds refreshInterval{1000};    // Least time between slot map reloads after MOVED
+};
+
+struct RedisClusterMetrics
+{
+    uint64_t commands = 0;
+    uint64_t moved = 0;
+    uint64_t asks = 0;
+    uint64_t refreshes = 0;
+    uint64_t batches = 0;
+    size_t nodes = 0;
+};
+
+// Redis Cluster client with a local slot map and a connection pool per primary.
+//
+// The slot map is loaded with CLUSTER SHARDS, or CLUSTER SLOTS before Redis 7, and
+// every keyed command is sent straight to the primary owning its hash slot. MOVED
+// updates the slot and schedules a reload, ASK is followed for a single command.
+// Slot lookups are lock-free; nodes are added as they are discovered and kept for
+// the lifetime of the cluster so a lookup never sees a node go away.
+class RedisCluster
+{
+
+public:
+
+    static constexpr size_t slotCount = 16384;
+
+    // Connects to the seed node and loads the slot map, throws when it cannot
+    RedisCluster(std::string host, int port, RedisClusterConfig config = RedisClusterConfig());
+    ~RedisCluster();
+
+    RedisCluster(const RedisCluster&) = delete;
+    RedisCluster& operator=(const RedisCluster&) = delete;
+
+    // CRC16 of the key, or of its {hash tag}, modulo 16384
+    static uint16_t keySlot(std::string_view key);
+
+    // Target of a MOVED or ASK error, an empty host means the node that answered
+    struct Redirect
+    {
+        bool ask = false;
+        uint16_t slot = 0;
+        std::string host;
+        int port = 0;
+    };
+
+    // False when the reply is not a well formed MOVED or ASK error
+    static bool parseRedirect(const redisReply* reply, Redirect& redirect);
+
+    // Routed by the key, an empty key goes to any node. The caller frees the reply
+    redisReply* executeArgv(int argc, const char** argv, const size_t* argvlen, std::string_view key);
+    redisReply* executeArgv(const std::vector<std::string>& argv);
+    redisReply* executeFormatted(const std::string& formatted, std::string_view key);
+
+    // Commands grouped by node, each group pipelined on its own connection and the
+    // groups run in parallel. argv[keyIndex] routes each command; replies keep the
+    // order of the commands
+    std::vector<RedisReplyPtr> executeBatch(const std::vector<std::vector<std::string>>& commands,
+                                            size_t keyIndex = 1);
+
+    // MGET split into one MGET per slot, sent as one batch
+    std::vector<std::optional<std::string>> mget(const std::vector<std::string>& keys);
+
+    // Connection to the primary owning the key, for pipelines that stay on one node
+    RedisConnectionPool::Lease acquire(std::string_view key);
+
+    // Reload the slot map from the first node that answers
+    void refreshSlots();
+
+    std::string nodeFor(std::string_view key) const;
+    RedisClusterMetrics metrics() const;
+
+private:
+    struct Node
+    {
+        std::string host;
+        int port = 0;
+        std::unique_ptr<RedisConnectionPool> pool;
+    };
+
+    const RedisClusterConfig config;
+
+    // Nodes are only ever appended, guarded by nodeMutex
+    mutable std::mutex nodeMutex;
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unique_ptr<std::atomic<Node*>[]> slots;
+
+    std::mutex refreshMutex;
+    std::atomic<int64_t> lastRefresh{0};
+
+    std::atomic<uint64_t> commands{0};
+    std::atomic<uint64_t> moved{0};
+    std::atomic<uint64_t> asks{0};
+    std::atomic<uint64_t> refreshes{0};
+    std::atomic<uint64_t> batches{0};
+
+    Node* node(const std::string& host, int port);
+    Node* nodeForSlot(uint16_t slot);
+    Node* anyNode() const;
+    bool loadSlots(Node& source);
+    redisReply* route(std::string_view key, const std::function<redisReply*(redisContext*)>& send);
+    void onMoved();
+
+};
+
+#endif // REDIS_CLUSTER_H
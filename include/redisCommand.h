@@ -0,0 +1,149 @@
+#ifndef REDIS_COMMAND_H
+#define REDIS_COMMAND_H
+
+// System Includes
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A command with a fixed number of arguments whose RESP header is built at compile time.
+//
+// The header covers the array length and the command name, for example SET with two
+// arguments precomputes "*3\r\n$3\r\nSET\r\n". Only the arguments are encoded per call.
+template <size_t Arity>
+class RedisCommand
+{
+
+public:
+
+    template <size_t N>
+    constexpr RedisCommand(const char (&name)[N])
+    {
+        static_assert(N > 1, "Command name must not be empty");
+        static_assert(N + 2 * 20 + 8 <= 64, "Command name is too long");
+
+        bytes[length++] = '*';
+        appendNumber(Arity + 1);
+        appendCrlf();
+        bytes[length++] = '$';
+        appendNumber(N - 1);
+        appendCrlf();
+        for (size_t i = 0; i < N - 1; ++i) {
+            bytes[length++] = name[i];
+        }
+        appendCrlf();
+    }
+
+    constexpr std::string_view header() const
+    {
+        return std::string_view(bytes.data(), length);
+    }
+
+    static constexpr size_t arity()
+    {
+        return Arity;
+    }
+
+private:
+    std::array<char, 64> bytes{};
+    size_t length = 0;
+
+    constexpr void appendNumber(size_t value)
+    {
+        char digits[20] = {};
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (count > 0) {
+            bytes[length++] = digits[--count];
+        }
+    }
+
+    constexpr void appendCrlf()
+    {
+        bytes[length++] = '\r';
+        bytes[length++] = '\n';
+    }
+
+};
+
+// Commonly used fixed commands
+namespace RedisCommands
+{
+    inline constexpr RedisCommand<1> GET{"GET"};
+    inline constexpr RedisCommand<2> SET{"SET"};
+    inline constexpr RedisCommand<1> DEL{"DEL"};
+    inline constexpr RedisCommand<1> INCR{"INCR"};
+    inline constexpr RedisCommand<2> PUBLISH{"PUBLISH"};
+    inline constexpr RedisCommand<0> PING{"PING"};
+    inline constexpr RedisCommand<0> MULTI{"MULTI"};
+    inline constexpr RedisCommand<0> EXEC{"EXEC"};
+}
+
+namespace RedisProtocol
+{
+    // Append one RESP bulk string, "$<len>\r\n<data>\r\n"
+    inline void appendBulk(std::string& out, std::string_view arg)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), arg.size());
+        out += '$';
+        out.append(digits, result.ptr);
+        out.append("\r\n", 2);
+        out.append(arg.data(), arg.size());
+        out.append("\r\n", 2);
+    }
+
+    // Append a RESP array header, "*<count>\r\n"
+    inline void appendCount(std::string& out, size_t count)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), count);
+        out += '*';
+        out.append(digits, result.ptr);
+        out.append("\r\n", 2);
+    }
+
+    // Encode any command, every argument sent as-is as one bulk string
+    template <typename... Args>
+    std::string formatArgs(const Args&... args)
+    {
+        static_assert(sizeof...(Args) > 0, "A command needs at least its name");
+
+        std::string out;
+        out.reserve(16 + ((std::string_view(args).size() + 16) + ...));
+        appendCount(out, sizeof...(Args));
+        (appendBulk(out, std::string_view(args)), ...);
+        return out;
+    }
+
+    inline std::string formatArgv(const std::vector<std::string>& argv)
+    {
+        std::string out;
+        appendCount(out, argv.size());
+        for (const auto& arg : argv) {
+            appendBulk(out, arg);
+        }
+        return out;
+    }
+
+    // Encode a fixed command and its arguments into a single RESP buffer
+    template <size_t Arity, typename... Args>
+    std::string formatCommand(const RedisCommand<Arity>& command, const Args&... args)
+    {
+        static_assert(sizeof...(Args) == Arity, "Wrong number of arguments for command");
+
+        std::string out;
+        out.reserve(command.header().size() + ((std::string_view(args).size() + 16) + ... + 0));
+        out.append(command.header().data(), command.header().size());
+        (appendBulk(out, std::string_view(args)), ...);
+        return out;
+    }
+}
+
+#endif // REDIS_COMMAND_H
@@ -0,0 +1,133 @@
+#ifndef REDIS_CONNECTION_POOL_H
+#define REDIS_CONNECTION_POOL_H
+
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisReconnect.h"
+#include "redisReplyArena.h"
+
+struct RedisPoolConfig
+{
+    size_t size = 0;                                        // 0 uses the hardware thread count
+    std::chrono::milliseconds acquireTimeout{1000};         // Give up waiting for a free connection
+    std::chrono::milliseconds healthCheckInterval{5000};    // PING a connection idle for longer than this
+};
+
+struct RedisPoolMetrics
+{
+    uint64_t acquires = 0;
+    uint64_t stickyHits = 0;        // Served by the calling thread's own connection
+    uint64_t contended = 0;         // Had to wait for a connection to be released
+    uint64_t timeouts = 0;
+    uint64_t totalWaitNanos = 0;
+    uint64_t maxWaitNanos = 0;
+    uint64_t healthChecks = 0;
+    uint64_t reconnects = 0;
+    size_t inUse = 0;
+};
+
+// Fixed size pool of blocking connections shared by many threads.
+//
+// Checkout is lock-free: every connection has an atomic busy flag claimed with a CAS.
+// Each thread first tries the connection matching its own thread ordinal, so N
+// threads on a pool of N connections never contend, and falls back to scanning the
+// other slots when its connection is taken.
+class RedisConnectionPool
+{
+
+public:
+
+    // A checked out connection, returned to the pool on destruction
+    class Lease
+    {
+
+    public:
+
+        Lease() = default;
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+
+        redisContext* get() const;
+        redisContext* operator->() const;
+        RedisReplyArena* arena() const;
+        explicit operator bool() const;
+        void release();
+
+    private:
+        friend class RedisConnectionPool;
+        Lease(RedisConnectionPool* pool, size_t slot);
+
+        RedisConnectionPool* pool = nullptr;
+        size_t slot = 0;
+    };
+
+    RedisConnectionPool(std::string host, int port, RedisPoolConfig config = RedisPoolConfig());
+    ~RedisConnectionPool();
+
+    RedisConnectionPool(const RedisConnectionPool&) = delete;
+    RedisConnectionPool& operator=(const RedisConnectionPool&) = delete;
+
+    // Blocks up to acquireTimeout, throws when no connection becomes free
+    Lease acquire();
+
+    // PING every idle connection and reconnect broken ones, returns how many were repaired
+    size_t checkHealth();
+
+    // Points every connection at another server, each reconnects when next acquired
+    void moveTo(const RedisEndpoint& endpoint);
+
+    size_t size() const;
+    RedisPoolMetrics metrics() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<bool> busy{false};
+        redisContext* context = nullptr;
+        std::unique_ptr<RedisReplyArena> arena;
+        std::chrono::steady_clock::time_point lastChecked;
+        uint64_t generation = 0;
+    };
+
+    const std::string serverHost;
+    const int serverPort;
+    const RedisPoolConfig config;
+    const size_t poolSize;
+    std::unique_ptr<Slot[]> slots;
+
+    // Address set by moveTo, slots behind targetGeneration are re-pointed
+    std::mutex targetMutex;
+    RedisEndpoint target;
+    std::atomic<uint64_t> targetGeneration{0};
+
+    // Metrics
+    std::atomic<uint64_t> acquires{0};
+    std::atomic<uint64_t> stickyHits{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint64_t> totalWaitNanos{0};
+    std::atomic<uint64_t> maxWaitNanos{0};
+    std::atomic<uint64_t> healthChecks{0};
+    std::atomic<uint64_t> reconnects{0};
+    std::atomic<size_t> inUse{0};
+
+    bool tryClaim(size_t slot);
+    bool ensureHealthy(Slot& slot, bool force);
+    void release(size_t slot);
+    void recordWait(uint64_t nanos);
+
+};
+
+#endif // REDIS_CONNECTION_POOL_H
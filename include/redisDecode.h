@@ -0,0 +1,434 @@
+#ifndef REDIS_DECODE_H
+#define REDIS_DECODE_H
+
+// System Includes
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+
+// Receives the values of a reply while the reader parses it, one call per value.
+//
+// Bound into a context's reader the hiredis object functions call straight into the
+// sink, so a reply is decoded into its target type without building a redisReply
+// tree first. Aggregates hand back the sink their elements go to. Errors cannot
+// travel through the C reader, the first error reply or type mismatch is kept and
+// thrown by check() once the reply is complete.
+class RedisDecodeSink
+{
+
+public:
+
+    // Swaps the sink into a context's reader for one reply, restoring the previous
+    // reply functions on destruction. Must be created between replies.
+    class Binding
+    {
+
+    public:
+
+        Binding(redisContext* context, RedisDecodeSink& sink);
+        ~Binding();
+
+        Binding(const Binding&) = delete;
+        Binding& operator=(const Binding&) = delete;
+
+    private:
+        redisReader* reader;
+        redisReplyObjectFunctions* previousFunctions;
+        void* previousPrivdata;
+
+        // Sink receiving the values at each nesting depth, the root at depth 0
+        std::vector<RedisDecodeSink*> levels;
+
+        RedisDecodeSink* sinkFor(const redisReadTask* task) const;
+
+        static Binding* bindingOf(const redisReadTask* task);
+        static void* createString(const redisReadTask* task, char* str, size_t len);
+        static void* createArray(const redisReadTask* task, size_t elements);
+        static void* createInteger(const redisReadTask* task, long long value);
+        static void* createDouble(const redisReadTask* task, double value, char* str, size_t len);
+        static void* createNil(const redisReadTask* task);
+        static void* createBool(const redisReadTask* task, int value);
+        static void freeObject(void* reply);
+
+        static redisReplyObjectFunctions functions;
+    };
+
+    RedisDecodeSink() = default;
+    virtual ~RedisDecodeSink() = default;
+
+    RedisDecodeSink(const RedisDecodeSink&) = delete;
+    RedisDecodeSink& operator=(const RedisDecodeSink&) = delete;
+
+    // Value callbacks, anything not overridden is recorded as a type mismatch
+    virtual void string(int type, const char* str, size_t len);
+    virtual void integer(long long value);
+    virtual void number(double value);
+    virtual void nil();
+    virtual void boolean(bool value);
+    virtual RedisDecodeSink* array(int type, size_t elements);
+
+    // Walks an already built reply through the same callbacks
+    void decode(const redisReply* reply);
+
+    // Throws the first error reply or type mismatch seen while decoding
+    void check() const;
+
+protected:
+    // Sink whose failure is reported, nested sinks point at the root they decode for
+    RedisDecodeSink* owner = this;
+
+    void fail(std::string message);
+    void mismatch(const char* expected, int type);
+
+    // True, and recorded as the failure, when the string is an error reply
+    bool isError(int type, const char* str, size_t len);
+
+    // Swallows the elements of an aggregate that has already failed to decode
+    static RedisDecodeSink* ignore();
+
+private:
+    std::string failure;
+
+};
+
+// Decodes one reply into a T. Specialised for integers, floating point, bool,
+// std::string, std::optional, std::vector, std::map and std::unordered_map,
+// nested in any combination.
+template <typename T, typename Enable = void>
+class RedisDecoder;
+
+// Shared target handling of the decoders below
+template <typename T>
+class RedisDecoderBase : public RedisDecodeSink
+{
+
+public:
+
+    RedisDecoderBase() = default;
+    explicit RedisDecoderBase(T& target) : target(&target) {}
+
+    // Points the decoder at the next value of an aggregate
+    void bind(T& value, RedisDecodeSink* root)
+    {
+        target = &value;
+        owner = root;
+    }
+
+protected:
+    T* target = nullptr;
+
+};
+
+template <typename T>
+class RedisDecoder<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    : public RedisDecoderBase<T>
+{
+
+public:
+
+    using RedisDecoderBase<T>::RedisDecoderBase;
+
+    // Checked against T's range the same way from_chars checks a string below
+    void integer(long long value) override
+    {
+        bool fits = false;
+        if constexpr (std::is_signed_v<T>) {
+            fits = value >= std::numeric_limits<T>::min() && value <= std::numeric_limits<T>::max();
+        } else {
+            fits = value >= 0 && static_cast<unsigned long long>(value) <= std::numeric_limits<T>::max();
+        }
+        if (!fits) {
+            this->fail("Reply is out of range: " + std::to_string(value));
+            return;
+        }
+        *this->target = static_cast<T>(value);
+    }
+
+    // Numbers stored as strings, as GET returns them
+    void string(int type, const char* str, size_t len) override
+    {
+        if (this->isError(type, str, len)) {
+            return;
+        }
+        auto result = std::from_chars(str, str + len, *this->target);
+        if (result.ec == std::errc::result_out_of_range) {
+            this->fail("Reply is out of range: " + std::string(str, len));
+        } else if (result.ec != std::errc() || result.ptr != str + len) {
+            this->fail("Reply is not an integer: " + std::string(str, len));
+        }
+    }
+
+};
+
+template <typename T>
+class RedisDecoder<T, std::enable_if_t<std::is_floating_point_v<T>>> : public RedisDecoderBase<T>
+{
+
+public:
+
+    using RedisDecoderBase<T>::RedisDecoderBase;
+
+    void number(double value) override
+    {
+        *this->target = static_cast<T>(value);
+    }
+
+    void integer(long long value) override
+    {
+        *this->target = static_cast<T>(value);
+    }
+
+    void string(int type, const char* str, size_t len) override
+    {
+        if (this->isError(type, str, len)) {
+            return;
+        }
+        // Bulk strings are not terminated when decoded in place, copy for strtod
+        std::string text(str, len);
+        char* end = nullptr;
+        *this->target = static_cast<T>(std::strtod(text.c_str(), &end));
+        if (text.empty() || end != text.c_str() + text.size()) {
+            this->fail("Reply is not a number: " + text);
+        }
+    }
+
+};
+
+template <>
+class RedisDecoder<bool> : public RedisDecoderBase<bool>
+{
+
+public:
+
+    using RedisDecoderBase<bool>::RedisDecoderBase;
+
+    void boolean(bool value) override
+    {
+        *target = value;
+    }
+
+    void integer(long long value) override
+    {
+        *target = value != 0;
+    }
+
+    // +OK and friends count as true
+    void string(int type, const char* str, size_t len) override
+    {
+        if (isError(type, str, len)) {
+            return;
+        }
+        if (type != REDIS_REPLY_STATUS) {
+            mismatch("boolean", type);
+            return;
+        }
+        *target = true;
+    }
+
+};
+
+template <>
+class RedisDecoder<std::string> : public RedisDecoderBase<std::string>
+{
+
+public:
+
+    using RedisDecoderBase<std::string>::RedisDecoderBase;
+
+    void string(int type, const char* str, size_t len) override
+    {
+        if (isError(type, str, len)) {
+            return;
+        }
+        target->assign(str, len);
+    }
+
+};
+
+template <typename T>
+class RedisDecoder<std::optional<T>> : public RedisDecoderBase<std::optional<T>>
+{
+
+public:
+
+    using RedisDecoderBase<std::optional<T>>::RedisDecoderBase;
+
+    void nil() override { this->target->reset(); }
+    void string(int type, const char* str, size_t len) override { emplace().string(type, str, len); }
+    void integer(long long value) override { emplace().integer(value); }
+    void number(double value) override { emplace().number(value); }
+    void boolean(bool value) override { emplace().boolean(value); }
+    RedisDecodeSink* array(int type, size_t elements) override { return emplace().array(type, elements); }
+
+private:
+    RedisDecoder<T> inner;
+
+    RedisDecoder<T>& emplace()
+    {
+        inner.bind(this->target->emplace(), this->owner);
+        return inner;
+    }
+
+};
+
+// Element sink of the container decoders, every value it receives is one element
+template <typename Store>
+class RedisElementSink : public RedisDecodeSink
+{
+
+public:
+
+    explicit RedisElementSink(Store store) : store(store) {}
+
+    void reset(RedisDecodeSink* root)
+    {
+        owner = root;
+        index = 0;
+    }
+
+    void string(int type, const char* str, size_t len) override { next().string(type, str, len); }
+    void integer(long long value) override { next().integer(value); }
+    void number(double value) override { next().number(value); }
+    void nil() override { next().nil(); }
+    void boolean(bool value) override { next().boolean(value); }
+    RedisDecodeSink* array(int type, size_t elements) override { return next().array(type, elements); }
+
+private:
+    Store store;
+    size_t index = 0;
+
+    RedisDecodeSink& next()
+    {
+        return store(index++, owner);
+    }
+
+};
+
+template <typename T>
+class RedisDecoder<std::vector<T>> : public RedisDecoderBase<std::vector<T>>
+{
+
+public:
+
+    using RedisDecoderBase<std::vector<T>>::RedisDecoderBase;
+
+    // A nil array decodes as an empty vector
+    void nil() override { this->target->clear(); }
+
+    RedisDecodeSink* array(int type, size_t elements) override
+    {
+        (void)type;
+        this->target->clear();
+        this->target->reserve(elements);
+        sink.reset(this->owner);
+        return &sink;
+    }
+
+private:
+    RedisDecoder<T> item;
+
+    // Elements are appended as they arrive, nested aggregates finish before the next one
+    struct Append
+    {
+        RedisDecoder<std::vector<T>>* decoder;
+        RedisDecodeSink& operator()(size_t, RedisDecodeSink* root) const
+        {
+            decoder->item.bind(decoder->target->emplace_back(), root);
+            return decoder->item;
+        }
+    };
+    RedisElementSink<Append> sink{Append{this}};
+
+};
+
+// Maps decode from RESP3 maps and from the flat name/value arrays of RESP2
+template <typename Map>
+class RedisMapDecoder : public RedisDecoderBase<Map>
+{
+
+public:
+
+    using Key = typename Map::key_type;
+    using Value = typename Map::mapped_type;
+
+    using RedisDecoderBase<Map>::RedisDecoderBase;
+
+    void nil() override { this->target->clear(); }
+
+    RedisDecodeSink* array(int type, size_t elements) override
+    {
+        if (elements % 2 != 0) {
+            this->mismatch("map", type);
+            return this->ignore();
+        }
+        this->target->clear();
+        sink.reset(this->owner);
+        return &sink;
+    }
+
+private:
+    RedisDecoder<Key> keyDecoder;
+    RedisDecoder<Value> valueDecoder;
+    Key key{};
+
+    // Even elements are keys, each odd element the value of the key before it
+    struct Pair
+    {
+        RedisMapDecoder<Map>* decoder;
+        RedisDecodeSink& operator()(size_t index, RedisDecodeSink* root) const
+        {
+            if (index % 2 == 0) {
+                decoder->key = Key{};
+                decoder->keyDecoder.bind(decoder->key, root);
+                return decoder->keyDecoder;
+            }
+            decoder->valueDecoder.bind((*decoder->target)[std::move(decoder->key)], root);
+            return decoder->valueDecoder;
+        }
+    };
+    RedisElementSink<Pair> sink{Pair{this}};
+
+};
+
+template <typename K, typename V, typename... Rest>
+class RedisDecoder<std::unordered_map<K, V, Rest...>> : public RedisMapDecoder<std::unordered_map<K, V, Rest...>>
+{
+
+public:
+
+    using RedisMapDecoder<std::unordered_map<K, V, Rest...>>::RedisMapDecoder;
+
+};
+
+template <typename K, typename V, typename... Rest>
+class RedisDecoder<std::map<K, V, Rest...>> : public RedisMapDecoder<std::map<K, V, Rest...>>
+{
+
+public:
+
+    using RedisMapDecoder<std::map<K, V, Rest...>>::RedisMapDecoder;
+
+};
+
+// Decodes a reply that was already built, for replies from other paths such as cluster redirects
+template <typename T>
+T redisDecode(const redisReply* reply)
+{
+    T value{};
+    RedisDecoder<T> decoder(value);
+    decoder.decode(reply);
+    decoder.check();
+    return value;
+}
+
+#endif // REDIS_DECODE_H
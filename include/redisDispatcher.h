@@ -0,0 +1,113 @@
+#ifndef REDIS_DISPATCHER_H
+#define REDIS_DISPATCHER_H
+
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisBoundedQueue.h"
+#include "redisReply.h"
+
+// What the reader does when a worker queue is full
+enum class OverflowPolicy
+{
+    Block,        // Wait for the worker to make room, pushing back on the socket
+    DropNewest,   // Discard the incoming message
+    DropOldest    // Discard the oldest queued message to make room
+};
+
+struct RedisDispatchConfig
+{
+    size_t workers = 0;             // 0 delivers on the reader thread
+    size_t queueCapacity = 4096;    // Per worker, rounded up to a power of two
+    OverflowPolicy overflow = OverflowPolicy::Block;
+};
+
+struct RedisDispatchMetrics
+{
+    uint64_t dispatched = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t blocked = 0;           // Messages that had to wait for queue space
+    size_t queueDepth = 0;
+};
+
+// Hands pub/sub messages from the socket reader to a pool of worker threads.
+//
+// Each channel hashes to one worker, so messages of a channel are delivered in order
+// while different channels are handled in parallel. Every worker drains its own
+// bounded lock-free queue; the reader never waits on a handler unless the overflow
+// policy is Block and that worker's queue is full.
+class RedisMessageDispatcher
+{
+
+public:
+
+    // Called with each message and the time the reader took it off the socket
+    using Handler = std::function<void(const redisReply*, std::chrono::steady_clock::time_point)>;
+
+    RedisMessageDispatcher(RedisDispatchConfig config, Handler handler);
+    ~RedisMessageDispatcher();
+
+    RedisMessageDispatcher(const RedisMessageDispatcher&) = delete;
+    RedisMessageDispatcher& operator=(const RedisMessageDispatcher&) = delete;
+
+    // Queue a message for its channel's worker, the dispatcher takes ownership
+    void dispatch(RedisReplyPtr message,
+                  std::chrono::steady_clock::time_point received = std::chrono::steady_clock::now());
+
+    // Let the workers drain their queues, then join them
+    void stop();
+
+    size_t workerFor(std::string_view channel) const;
+    size_t queueDepth() const;
+    RedisDispatchMetrics metrics() const;
+
+private:
+    struct Delivery
+    {
+        redisReply* message = nullptr;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    struct Worker
+    {
+        explicit Worker(size_t capacity) : queue(capacity) {}
+
+        RedisBoundedQueue<Delivery> queue;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::atomic<bool> sleeping{false};
+        // The reader waits on space while the queue is full under OverflowPolicy::Block
+        std::condition_variable space;
+        std::atomic<bool> full{false};
+    };
+
+    const RedisDispatchConfig config;
+    const Handler handler;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> running{true};
+
+    std::atomic<uint64_t> dispatched{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> blocked{0};
+
+    void workerLoop(Worker& worker);
+    void notify(Worker& worker);
+    void waitForSpace(Worker& worker, Delivery& delivery);
+
+};
+
+#endif // REDIS_DISPATCHER_H
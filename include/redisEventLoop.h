@@ -0,0 +1,90 @@
+#ifndef REDIS_EVENT_LOOP_H
+#define REDIS_EVENT_LOOP_H
+
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project Includes
+#include <async.h>
+
+// Linux epoll event loop that drives any number of redisAsyncContexts from one thread.
+//
+// attach() installs the hiredis ev hooks (addRead/delRead/addWrite/delWrite/cleanup/
+// scheduleTimer) so hiredis registers interest with this loop instead of an external
+// event library. Async contexts are not thread-safe, so commands issued from other
+// threads must be handed over with post().
+class RedisEventLoop
+{
+
+public:
+
+    RedisEventLoop();
+    ~RedisEventLoop();
+
+    RedisEventLoop(const RedisEventLoop&) = delete;
+    RedisEventLoop& operator=(const RedisEventLoop&) = delete;
+
+    // Install the event hooks on a context, call from the loop thread or before start()
+    void attach(redisAsyncContext* context);
+
+    // Loop control
+    void start();
+    void stop();
+    void run();
+    void runOnce(int timeoutMs);
+    bool isRunning() const;
+    bool inLoopThread() const;
+
+    // Run a task on the loop thread, safe to call from any thread
+    void post(std::function<void()> task);
+    // As post(), but wait for the task to finish. Runs inline on the loop thread
+    // or when the loop is not running, tasks queued before stop() still run
+    void invoke(std::function<void()> task);
+
+private:
+    struct Watch
+    {
+        RedisEventLoop* loop;
+        redisAsyncContext* context;
+        int fd;
+        uint32_t events;
+        bool registered;
+        bool timerArmed;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::atomic<bool> running{false};
+    std::thread loopThread;
+    std::atomic<std::thread::id> loopThreadId;
+
+    mutable std::mutex taskMutex;
+    std::vector<std::function<void()>> tasks;
+
+    std::vector<Watch*> watches;
+    std::vector<Watch*> retired;
+
+    void wake();
+    void updateInterest(Watch* watch, uint32_t events);
+    void runTasks();
+    void runTimers();
+    void releaseRetired();
+    int nextTimeout(int timeoutMs) const;
+
+    // hiredis ev hooks
+    static void addRead(void* privdata);
+    static void delRead(void* privdata);
+    static void addWrite(void* privdata);
+    static void delWrite(void* privdata);
+    static void cleanup(void* privdata);
+    static void scheduleTimer(void* privdata, struct timeval tv);
+
+};
+
+#endif // REDIS_EVENT_LOOP_H
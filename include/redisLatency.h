@@ -0,0 +1,129 @@
+#ifndef REDIS_LATENCY_H
+#define REDIS_LATENCY_H
+
+// System Includes
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Merged, read-only copy of one metric's histogram
+struct RedisLatencySnapshot
+{
+    uint64_t count = 0;
+    uint64_t totalNanos = 0;
+    uint64_t maxNanos = 0;
+    std::vector<uint64_t> buckets;
+
+    // Upper bound of the bucket holding the given fraction of samples, within 1/16
+    uint64_t percentile(double fraction) const;
+    double meanNanos() const;
+    void merge(const RedisLatencySnapshot& other);
+};
+
+// Log-linear latency histogram in the style of HdrHistogram.
+//
+// Values below 16ns get a bucket each, above that every power of two is split into
+// 16 linear sub-buckets, so any recorded value is off by at most 1/16. A histogram
+// has a single writer thread; readers may copy it at any time without locking.
+class RedisLatencyHistogram
+{
+
+public:
+
+    static constexpr unsigned subBucketBits = 4;
+    static constexpr size_t subBuckets = size_t(1) << subBucketBits;
+    static constexpr size_t bucketCount = (64 - subBucketBits + 1) * subBuckets;
+
+    // Owning thread only, wait-free
+    void record(uint64_t nanos);
+
+    // Any thread, counts recorded concurrently may or may not be included
+    void addTo(RedisLatencySnapshot& snapshot) const;
+
+    static size_t bucketOf(uint64_t nanos);
+    static uint64_t upperBound(size_t bucket);
+
+private:
+    std::array<std::atomic<uint64_t>, bucketCount> counts{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNanos{0};
+    std::atomic<uint64_t> maxNanos{0};
+
+};
+
+// Per-thread latency recording keyed by metric name, merged when read.
+//
+// Every thread records into its own histograms, so recording never contends and
+// never takes a lock once the thread and metric have been seen. A thread's histograms
+// are folded into a shared total and freed when the thread exits. Metric names are
+// interned the first time they are used; past maxMetrics everything lands in OTHER.
+class RedisLatencyRecorder
+{
+
+public:
+
+    static constexpr size_t maxMetrics = 64;
+
+    RedisLatencyRecorder();
+    ~RedisLatencyRecorder();
+
+    RedisLatencyRecorder(const RedisLatencyRecorder&) = delete;
+    RedisLatencyRecorder& operator=(const RedisLatencyRecorder&) = delete;
+
+    // Stable id for a metric name
+    size_t metric(std::string_view name);
+
+    void record(size_t metric, uint64_t nanos);
+    void record(size_t metric, std::chrono::steady_clock::time_point start);
+
+    // Merge of every thread's histograms, keyed by metric name
+    std::map<std::string, RedisLatencySnapshot> snapshot() const;
+
+    // Log every metric through spdlog at a fixed interval until stopped
+    void startDump(std::chrono::milliseconds interval);
+    void stopDump();
+
+private:
+    struct ThreadState
+    {
+        std::array<std::atomic<RedisLatencyHistogram*>, maxMetrics> histograms{};
+        ~ThreadState();
+    };
+
+    const uint64_t id;
+
+    // Names are written once before nameCount publishes them
+    std::array<std::string, maxMetrics> names;
+    std::atomic<size_t> nameCount{0};
+    std::mutex nameMutex;
+
+    mutable std::mutex threadMutex;
+    std::vector<std::unique_ptr<ThreadState>> threads;
+    std::array<RedisLatencySnapshot, maxMetrics> retired;      // Counts of threads that have exited
+
+    std::thread dumpThread;
+    std::mutex dumpMutex;
+    std::condition_variable dumpWake;
+    bool dumping = false;
+
+    // Null once the calling thread is exiting and its states are gone
+    ThreadState* local();
+    void dump() const;
+
+    // Called by an exiting thread for the state it kept with this recorder
+    void retire(ThreadState* state);
+
+    friend struct RedisLatencyThreadStates;
+
+};
+
+#endif // REDIS_LATENCY_H
@@ -0,0 +1,137 @@
+#ifndef REDIS_MESSAGE_H
+#define REDIS_MESSAGE_H
+
+// System Includes
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+// Lazily split view over separator delimited tokens, nothing is copied or allocated.
+//
+// Splits the same way std::getline does: "a::b" gives "a", "", "b", a trailing
+// separator does not produce an empty last token and an empty string has no tokens.
+class RedisTokenRange
+{
+
+public:
+
+    class iterator
+    {
+
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+        iterator(std::string_view text, char separator)
+            : rest(text), separator(separator), done(text.empty())
+        {
+            advance();
+        }
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+
+        iterator& operator++()
+        {
+            advance();
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            advance();
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const
+        {
+            return atEnd == other.atEnd && (atEnd || current.data() == other.current.data());
+        }
+
+        bool operator!=(const iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        std::string_view rest;
+        std::string_view current;
+        char separator = ':';
+        bool done = true;
+        bool atEnd = true;
+
+        void advance()
+        {
+            if (done) {
+                atEnd = true;
+                return;
+            }
+            atEnd = false;
+            size_t split = rest.find(separator);
+            if (split == std::string_view::npos) {
+                current = rest;
+                done = true;
+                return;
+            }
+            current = rest.substr(0, split);
+            rest.remove_prefix(split + 1);
+            done = rest.empty();
+        }
+    };
+
+    explicit RedisTokenRange(std::string_view text, char separator = ':')
+        : text(text), separator(separator)
+    {
+    }
+
+    iterator begin() const { return iterator(text, separator); }
+    iterator end() const { return iterator(); }
+
+    bool empty() const { return text.empty(); }
+
+    size_t size() const
+    {
+        size_t count = 0;
+        for (auto it = begin(); it != end(); ++it) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Token by position, an empty view when out of range
+    std::string_view operator[](size_t index) const
+    {
+        for (auto it = begin(); it != end(); ++it, --index) {
+            if (index == 0) {
+                return *it;
+            }
+        }
+        return std::string_view();
+    }
+
+private:
+    std::string_view text;
+    char separator;
+
+};
+
+// A pub/sub message viewed in place in the hiredis reply, valid until the callback returns
+struct RedisMessageView
+{
+    std::string_view channel;
+    std::string_view payload;
+    std::string_view pattern;       // The matching pattern of a pmessage, empty otherwise
+
+    RedisTokenRange tokens(char separator = ':') const
+    {
+        return RedisTokenRange(payload, separator);
+    }
+};
+
+#endif // REDIS_MESSAGE_H
@@ -0,0 +1,73 @@
+#ifndef REDIS_PIPELINE_H
+#define REDIS_PIPELINE_H
+
+// System Includes
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisCommand.h"
+#include "redisConnectionPool.h"
+#include "redisReply.h"
+
+// Queues commands on a context and collects every reply in one round trip.
+//
+// Commands are appended to the context output buffer with redisAppendCommandArgv,
+// nothing is sent until execute() is called. A pipeline destroyed before execute()
+// removes its commands from the buffer again, none of them reach the server. The
+// context must not be used for anything else while commands are queued.
+class Pipeline
+{
+
+public:
+
+    // A pooled connection is held through its lease until the pipeline goes away
+    explicit Pipeline(redisContext* context, RedisConnectionPool::Lease lease = RedisConnectionPool::Lease());
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+    Pipeline(Pipeline&& other) noexcept;
+    Pipeline& operator=(Pipeline&& other) = delete;
+
+    // Queue a command, returns the slot index of its reply
+    size_t append(std::initializer_list<std::string_view> argv);
+    size_t append(const std::vector<std::string>& argv);
+
+    // Queue a fixed command, only the arguments are encoded
+    template <size_t Arity, typename... Args>
+    size_t append(const RedisCommand<Arity>& command, const Args&... args)
+    {
+        return appendFormatted(RedisProtocol::formatCommand(command, args...));
+    }
+
+    // Command helpers
+    size_t set(std::string_view key, std::string_view value);
+    size_t get(std::string_view key);
+    size_t publish(std::string_view channel, std::string_view message);
+
+    // Flush the queued commands and read one reply per slot
+    std::vector<RedisResult> execute();
+
+    size_t size() const;
+    bool empty() const;
+
+private:
+    RedisConnectionPool::Lease lease;
+    redisContext* context;
+    size_t pending = 0;
+    size_t unsentBefore = 0;        // Bytes already waiting in the output buffer
+
+    size_t unsent() const;
+
+    template <typename Range>
+    size_t appendRange(const Range& argv);
+    size_t appendArgv(int argc, const char** argv, const size_t* argvlen);
+    size_t appendFormatted(const std::string& command);
+
+};
+
+#endif // REDIS_PIPELINE_H
@@ -0,0 +1,101 @@
+#ifndef REDIS_RECONNECT_H
+#define REDIS_RECONNECT_H
+
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Project Includes
+#include <hiredis.h>
+
+// Address of a Redis server
+struct RedisEndpoint
+{
+    std::string host;
+    int port = 0;
+};
+
+struct RedisReconnectConfig
+{
+    std::chrono::milliseconds initialDelay{50};     // Wait after the first failed attempt
+    std::chrono::milliseconds maxDelay{5000};       // The delay stops growing here
+    double multiplier = 2.0;
+    double jitter = 0.2;                            // Each delay is randomised by up to this fraction either way
+    size_t maxAttempts = 0;                         // 0 keeps trying until stopped
+    bool replay = false;                            // Resend queued publishes whose replies were lost, they may arrive twice
+};
+
+struct RedisReconnectMetrics
+{
+    uint64_t disconnects = 0;
+    uint64_t reconnects = 0;
+    uint64_t failedAttempts = 0;
+    uint64_t replayed = 0;
+    uint64_t totalRecoveryNanos = 0;     // Connection lost to connection restored, summed
+    uint64_t maxRecoveryNanos = 0;
+
+    void merge(const RedisReconnectMetrics& other);
+};
+
+// Brings one failed blocking context back with jittered exponential backoff.
+//
+// The first attempt is made straight away, after that the delay grows by multiplier
+// up to maxDelay and is spread by jitter so clients dropped by the same failover do
+// not reconnect in lockstep. A reconnector belongs to a single context; its metrics
+// may be read from any thread.
+class RedisReconnector
+{
+
+public:
+
+    explicit RedisReconnector(RedisReconnectConfig config = RedisReconnectConfig());
+
+    // Blocks until reconnected. Gives up once maxAttempts is spent or keepTrying
+    // returns false, which is checked at least every 50ms while waiting
+    bool reconnect(redisContext* context, const std::function<bool()>& keepTrying);
+
+    // Never waits, only attempts once the backoff for the previous failure has passed
+    bool tryReconnect(redisContext* context);
+
+    // Jittered delay before the given retry, counted from zero
+    std::chrono::milliseconds delay(size_t retry) const;
+
+    // Asked before every attempt, an address other than the context's re-points it
+    // and is tried straight away instead of waiting out the backoff
+    void follow(std::function<RedisEndpoint()> source);
+
+    // Points a TCP context at another address for its next redisReconnect, false when
+    // it already points there
+    static bool retarget(redisContext* context, const RedisEndpoint& endpoint);
+
+    void countReplayed(uint64_t count);
+    uint64_t lastRecoveryNanos() const;
+    RedisReconnectMetrics metrics() const;
+
+private:
+    const RedisReconnectConfig config;
+
+    // Owning thread only
+    bool down = false;
+    size_t failures = 0;
+    std::chrono::steady_clock::time_point downSince;
+    std::chrono::steady_clock::time_point nextAttempt;
+    std::function<RedisEndpoint()> source;
+
+    std::atomic<uint64_t> disconnects{0};
+    std::atomic<uint64_t> reconnects{0};
+    std::atomic<uint64_t> failedAttempts{0};
+    std::atomic<uint64_t> replayed{0};
+    std::atomic<uint64_t> totalRecoveryNanos{0};
+    std::atomic<uint64_t> maxRecoveryNanos{0};
+    std::atomic<uint64_t> lastRecovery{0};
+
+    void markDown();
+    bool attempt(redisContext* context);
+
+};
+
+#endif // REDIS_RECONNECT_H
@@ -0,0 +1,56 @@
+#ifndef REDIS_REPLY_H
+#define REDIS_REPLY_H
+
+// System Includes
+#include <memory>
+#include <string>
+
+// Project Includes
+#include <hiredis.h>
+
+// Frees a hiredis reply tree when the owning pointer goes out of scope
+struct RedisReplyDeleter
+{
+    void operator()(redisReply* reply) const
+    {
+        if (reply) {
+            freeReplyObject(reply);
+        }
+    }
+};
+
+using RedisReplyPtr = std::unique_ptr<redisReply, RedisReplyDeleter>;
+
+// Owning, typed view of a single reply
+class RedisResult
+{
+
+public:
+
+    RedisResult() = default;
+    explicit RedisResult(RedisReplyPtr reply);
+
+    // Type queries
+    bool isOk() const;
+    bool isError() const;
+    bool isNil() const;
+    bool isString() const;
+    bool isInteger() const;
+    bool isArray() const;
+
+    // Typed accessors, these throw when the reply holds a different type
+    std::string asString() const;
+    long long asInteger() const;
+    bool asBool() const;
+    std::string error() const;
+
+    // Raw access to the underlying reply, owned by this result
+    const redisReply* get() const;
+    redisReply* release();
+
+private:
+    RedisReplyPtr reply;
+
+};
+
+#endif // REDIS_REPLY_H
@@ -0,0 +1,98 @@
+#ifndef REDIS_REPLY_ARENA_H
+#define REDIS_REPLY_ARENA_H
+
+// System Includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+
+struct RedisArenaStats
+{
+    uint64_t replies = 0;           // Reply trees built in the arena
+    uint64_t nodes = 0;             // redisReply nodes built in the arena
+    uint64_t resets = 0;
+    size_t bytesReserved = 0;       // Block memory currently held
+    size_t highWater = 0;           // Largest single reply tree in bytes
+};
+
+// Bump allocator that hiredis builds reply trees into instead of malloc.
+//
+// Every node, element vector and string of a reply is carved out of large reusable
+// blocks, so consuming a reply costs one reset() instead of a free per node. Replies
+// built here must never be passed to freeReplyObject and are only valid until the
+// next reset(). RESP3 push replies are still built on the heap so push callbacks
+// can keep freeing them as usual.
+class RedisReplyArena
+{
+
+public:
+
+    // Swaps the arena into a context's reader for one scope, restoring the previous
+    // reply functions on destruction. Must be created between replies.
+    class Binding
+    {
+
+    public:
+
+        Binding(redisContext* context, RedisReplyArena& arena);
+        ~Binding();
+
+        Binding(const Binding&) = delete;
+        Binding& operator=(const Binding&) = delete;
+
+    private:
+        redisReader* reader;
+        redisReplyObjectFunctions* previousFunctions;
+        void* previousPrivdata;
+        RedisReplyArena* previousBound;
+    };
+
+    explicit RedisReplyArena(size_t blockSize = 64 * 1024, size_t retainBytes = 1024 * 1024);
+
+    RedisReplyArena(const RedisReplyArena&) = delete;
+    RedisReplyArena& operator=(const RedisReplyArena&) = delete;
+
+    // Reclaim every reply built since the last reset, keeping up to retainBytes of blocks
+    void reset();
+
+    bool owns(const void* pointer) const;
+    RedisArenaStats stats() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> memory;
+        size_t size = 0;
+    };
+
+    const size_t blockSize;
+    const size_t retainBytes;
+    std::vector<Block> blocks;
+    size_t current = 0;             // Block being carved
+    size_t offset = 0;              // Next free byte in the current block
+    size_t used = 0;                // Bytes handed out since the last reset
+    redisReplyObjectFunctions* fallback = nullptr;
+    RedisArenaStats counters;
+
+    void* allocate(size_t size);
+    redisReply* createNode(const redisReadTask* task, int type);
+
+    static RedisReplyArena* arenaOf(const redisReadTask* task);
+    static void* createString(const redisReadTask* task, char* str, size_t len);
+    static void* createArray(const redisReadTask* task, size_t elements);
+    static void* createInteger(const redisReadTask* task, long long value);
+    static void* createDouble(const redisReadTask* task, double value, char* str, size_t len);
+    static void* createNil(const redisReadTask* task);
+    static void* createBool(const redisReadTask* task, int value);
+    static void freeObject(void* reply);
+
+    static redisReplyObjectFunctions functions;
+    static thread_local RedisReplyArena* bound;
+
+};
+
+#endif // REDIS_REPLY_ARENA_H
@@ -0,0 +1,105 @@
+#ifndef REDIS_SENTINEL_H
+#define REDIS_SENTINEL_H
+
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisReconnect.h"
+
+struct RedisSentinelConfig
+{
+    std::string masterName;                             // Name the Sentinels monitor the master under
+    std::vector<RedisEndpoint> sentinels;
+    std::chrono::milliseconds timeout{500};             // Connect and reply timeout for each Sentinel
+    std::chrono::milliseconds retryInterval{250};       // Wait before trying the next Sentinel after a loss
+    bool readFromReplicas = false;                      // Serve reads from a healthy replica
+};
+
+struct RedisSentinelMetrics
+{
+    uint64_t switches = 0;          // Master address changes seen
+    uint64_t notifications = 0;     // +switch-master messages for this master
+    uint64_t resolves = 0;          // Master lookups answered by a Sentinel
+    uint64_t sentinelErrors = 0;    // Sentinels that could not be reached or dropped the connection
+    size_t replicas = 0;
+};
+
+// Master discovery and failover notification through Redis Sentinel.
+//
+// The master is resolved with SENTINEL get-master-addr-by-name, asking each Sentinel
+// in turn until one answers. Once started a watcher thread stays subscribed to
+// +switch-master on one Sentinel, moving to the next when it drops, and reports every
+// change of address through the switch callback. generation() changes with the master
+// so connection owners can notice a switch without taking a lock.
+class RedisSentinel
+{
+
+public:
+
+    // Called with the new master, on the watcher thread unless resolve() found the switch
+    using SwitchCallback = std::function<void(const RedisEndpoint& master)>;
+
+    // Resolves the master straight away, throws when no Sentinel knows it
+    explicit RedisSentinel(RedisSentinelConfig config);
+    ~RedisSentinel();
+
+    RedisSentinel(const RedisSentinel&) = delete;
+    RedisSentinel& operator=(const RedisSentinel&) = delete;
+
+    void start(SwitchCallback onSwitch);
+    void stop();
+
+    // Ask the Sentinels again, true when one answered
+    bool resolve();
+
+    RedisEndpoint master() const;
+    uint64_t generation() const;
+
+    // Replica chosen for reads, the master while no healthy replica is known
+    RedisEndpoint replica() const;
+    std::vector<RedisEndpoint> replicas() const;
+    bool readFromReplicas() const;
+
+    RedisSentinelMetrics metrics() const;
+
+private:
+    const RedisSentinelConfig config;
+
+    mutable std::mutex addressMutex;
+    RedisEndpoint currentMaster;
+    std::vector<RedisEndpoint> healthyReplicas;
+    RedisEndpoint chosenReplica;
+    std::atomic<uint64_t> masterGeneration{0};
+
+    // Sentinel that answered last, asked first next time
+    std::atomic<size_t> preferred{0};
+
+    SwitchCallback switchCallback;
+    std::thread watcher;
+    std::atomic<bool> running{false};
+    int wakeFd = -1;
+
+    std::atomic<uint64_t> notifications{0};
+    std::atomic<uint64_t> resolves{0};
+    std::atomic<uint64_t> sentinelErrors{0};
+
+    redisContext* connectSentinel(const RedisEndpoint& sentinel);
+    bool query(redisContext* context);
+    void updateMaster(const RedisEndpoint& master);
+    void watch();
+    void watchSentinel(redisContext* context);
+    void handleEvent(const std::string& channel, const std::string& payload);
+    bool pause(std::chrono::milliseconds interval);
+
+};
+
+#endif // REDIS_SENTINEL_H
@@ -0,0 +1,74 @@
+#ifndef REDIS_STREAM_H
+#define REDIS_STREAM_H
+
+// System Includes
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisDecode.h"
+
+// One value of a streamed reply. Strings point into the reader's buffer and are only
+// valid for the duration of the visitor call.
+struct RedisElementView
+{
+    int type = REDIS_REPLY_NIL;     // REDIS_REPLY_* type of the value
+    size_t depth = 0;               // 0 for the reply itself, 1 for its elements and so on
+    size_t index = 0;               // Position within the enclosing aggregate
+    std::string_view str;           // Strings, status, errors, big numbers and verbatim text
+    long long integer = 0;          // Integers, booleans and the element count of aggregates
+    double number = 0;
+};
+
+using RedisElementVisitor = std::function<void(const RedisElementView&)>;
+
+// Hands every value of a reply to a visitor while the reader parses it.
+//
+// Values arrive depth first, an aggregate before its elements, and are forgotten as soon
+// as the visitor returns, so however large the reply nothing grows but the reader's
+// socket buffer. Maps count keys and values as separate elements, the way RESP sends
+// them. An error reply as the whole reply fails the command, nested errors such as
+// those inside EXEC results are visited like any other value.
+class RedisStreamSink : public RedisDecodeSink
+{
+
+public:
+
+    explicit RedisStreamSink(const RedisElementVisitor& visitor);
+
+    void string(int type, const char* str, size_t len) override;
+    void integer(long long value) override;
+    void number(double value) override;
+    void nil() override;
+    void boolean(bool value) override;
+    RedisDecodeSink* array(int type, size_t elements) override;
+
+    // Elements of the reply itself visited so far
+    size_t elements() const;
+
+    // Throws what the visitor threw. The rest of the reply is still read, to keep the
+    // connection in step, but no longer visited
+    void rethrow() const;
+
+private:
+    RedisStreamSink(RedisStreamSink* root, size_t depth);
+
+    RedisStreamSink* root;
+    const RedisElementVisitor* visitor = nullptr;
+    size_t depth = 0;
+    size_t index = 0;
+    // Receives the elements one level down, reused by every aggregate at that depth
+    std::unique_ptr<RedisStreamSink> child;
+
+    size_t streamed = 0;
+    std::exception_ptr visitorFailure;
+
+    void visit(RedisElementView element);
+
+};
+
+#endif // REDIS_STREAM_H
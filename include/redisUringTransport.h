@@ -0,0 +1,67 @@
+#ifndef REDIS_URING_TRANSPORT_H
+#define REDIS_URING_TRANSPORT_H
+
+// System Includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Project Includes
+#include <hiredis.h>
+
+// io_uring transport for blocking redisContexts, installed through redisContextFuncs.
+//
+// One ring and one set of registered buffers are shared by every context installed on
+// the transport. A write submits the command as a MSG_WAITALL send linked to a fixed
+// buffer read, and a single io_uring_enter waits for both, so a request/reply round
+// trip costs one system call instead of a send and a recv. Completions for other
+// connections on the ring are reaped in the same call and kept until they are read.
+// The link is only used when a probe at construction finds the kernel retries short
+// MSG_WAITALL sends, otherwise the send and the read each take their own call.
+//
+// The ring is not thread-safe, every context installed on a transport must be used
+// from one thread at a time. When the kernel lacks io_uring, install() returns false
+// and the context keeps the plain socket path.
+class RedisUringTransport
+{
+
+public:
+
+    struct Stats
+    {
+        uint64_t enters = 0;        // io_uring_enter system calls
+        uint64_t sends = 0;
+        uint64_t receives = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t bytesRead = 0;
+    };
+
+    explicit RedisUringTransport(unsigned maxConnections = 64, size_t bufferSize = 16 * 1024);
+    ~RedisUringTransport();
+
+    RedisUringTransport(const RedisUringTransport&) = delete;
+    RedisUringTransport& operator=(const RedisUringTransport&) = delete;
+
+    // Whether the running kernel supports the transport
+    static bool isSupported();
+    bool isAvailable() const;
+
+    // Route a connected blocking context through the ring, false keeps the socket path
+    bool install(redisContext* context);
+
+    Stats stats() const;
+
+private:
+    struct Connection;
+    struct State;
+    std::unique_ptr<State> state;
+
+    // redisContextFuncs overrides
+    static ssize_t readReply(redisContext* context, char* buf, size_t bufcap);
+    static ssize_t writeCommand(redisContext* context);
+    static void closeConnection(redisContext* context);
+    static void releaseConnection(void* privdata);
+
+};
+
+#endif // REDIS_URING_TRANSPORT_H
@@ -785,6 +785,7 @@ int redisReconnect(redisContext *c) {
     redisReaderFree(c->reader);
 
     c->obuf = sdsempty();
+    c->obuf_pos = 0;
     c->reader = redisReaderCreate();
 
     if (c->obuf == NULL || c->reader == NULL) {
@@ -968,6 +969,15 @@ int redisSetTcpUserTimeout(redisContext *c, unsigned int timeout) {
     return redisContextSetTcpUserTimeout(c, timeout);
 }
 
+void redisSetOutputBufferRetention(redisContext *c, size_t maxobuf) {
+    /* Compact whatever is still unwritten before leaving retention mode */
+    if (maxobuf == 0 && c->obuf_pos > 0) {
+        sdsrange(c->obuf, c->obuf_pos, -1);
+        c->obuf_pos = 0;
+    }
+    c->obuf_max = maxobuf;
+}
+
 /* Set a user provided RESP3 PUSH handler and return any old one set. */
 redisPushFn *redisSetPushCallback(redisContext *c, redisPushFn *fn) {
     redisPushFn *old = c->push_cb;
@@ -1019,11 +1029,21 @@ int redisBufferWrite(redisContext *c, int *done) {
         if (nwritten < 0) {
             return REDIS_ERR;
         } else if (nwritten > 0) {
-            if (nwritten == (ssize_t)sdslen(c->obuf)) {
-                sdsfree(c->obuf);
-                c->obuf = sdsempty();
-                if (c->obuf == NULL)
-                    goto oom;
+            if (c->obuf_pos + (size_t)nwritten == sdslen(c->obuf)) {
+                /* Flushed. In retention mode the buffer keeps its capacity
+                 * unless a burst grew it past the high-water mark. */
+                c->obuf_pos = 0;
+                if (c->obuf_max > 0 && sdsalloc(c->obuf) <= c->obuf_max) {
+                    sdsclear(c->obuf);
+                } else {
+                    sdsfree(c->obuf);
+                    c->obuf = sdsempty();
+                    if (c->obuf == NULL)
+                        goto oom;
+                }
+            } else if (c->obuf_max > 0) {
+                /* Partial write, skip the written bytes instead of moving the rest */
+                c->obuf_pos += (size_t)nwritten;
             } else {
                 if (sdsrange(c->obuf,nwritten,-1) < 0) goto oom;
             }
@@ -1116,6 +1136,12 @@ int redisGetReply(redisContext *c, void **reply) {
 int __redisAppendCommand(redisContext *c, const char *cmd, size_t len) {
     sds newbuf;
 
+    /* Written bytes are only dropped when the buffer would otherwise grow */
+    if (c->obuf_pos > 0 && sdsavail(c->obuf) < len) {
+        sdsrange(c->obuf, c->obuf_pos, -1);
+        c->obuf_pos = 0;
+    }
+
     newbuf = sdscatlen(c->obuf,cmd,len);
     if (newbuf == NULL) {
         __redisSetError(c,REDIS_ERR_OOM,"Out of memory");
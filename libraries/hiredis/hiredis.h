@@ -99,6 +99,9 @@ typedef intptr_t ssize_t;
 
 #define REDIS_KEEPALIVE_INTERVAL 15 /* seconds */
 
+/* Default output buffer capacity kept between writes in retention mode. */
+#define REDIS_OBUF_MAX_RETAIN (1024*64)
+
 /* number of times we retry to connect in the case of EADDRNOTAVAIL and
  * SO_REUSEADDR is being used. */
 #define REDIS_CONNECT_RETRIES  10
@@ -294,6 +297,11 @@ typedef struct redisContext {
 
     /* An optional RESP3 PUSH handler */
     redisPushFn *push_cb;
+
+    /* Output buffer retention, see redisSetOutputBufferRetention(). When
+     * obuf_max is non-zero the bytes before obuf_pos have been written. */
+    size_t obuf_pos;
+    size_t obuf_max;
 } redisContext;
 
 redisContext *redisConnectWithOptions(const redisOptions *options);
@@ -325,6 +333,11 @@ int redisSetTimeout(redisContext *c, const struct timeval tv);
 int redisEnableKeepAlive(redisContext *c);
 int redisEnableKeepAliveWithInterval(redisContext *c, int interval);
 int redisSetTcpUserTimeout(redisContext *c, unsigned int timeout);
+
+/* Keep the output buffer between writes instead of freeing it once flushed.
+ * Its capacity is reused up to maxobuf bytes and partial writes only advance
+ * an offset. A maxobuf of 0 restores the default allocate-per-write behavior. */
+void redisSetOutputBufferRetention(redisContext *c, size_t maxobuf);
 void redisFree(redisContext *c);
 redisFD redisFreeKeepFd(redisContext *c);
 int redisBufferRead(redisContext *c);
@@ -48,6 +48,13 @@
 #include "sockcompat.h"
 #include "win32.h"
 
+/* A peer that went away must show up as EPIPE on whichever thread writes to
+ * it, rather than kill the process with SIGPIPE. Platforms without the flag
+ * keep the default. */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 /* Defined in hiredis.c */
 void __redisSetError(redisContext *c, int type, const char *str);
 
@@ -85,7 +92,7 @@ ssize_t redisNetRead(redisContext *c, char *buf, size_t bufcap) {
 ssize_t redisNetWrite(redisContext *c) {
     ssize_t nwritten;
 
-    nwritten = send(c->fd, c->obuf, sdslen(c->obuf), 0);
+    nwritten = send(c->fd, c->obuf + c->obuf_pos, sdslen(c->obuf) - c->obuf_pos, MSG_NOSIGNAL);
     if (nwritten < 0) {
         if ((errno == EWOULDBLOCK && !(c->flags & REDIS_BLOCK)) || (errno == EINTR)) {
             /* Try again */
@@ -222,6 +222,60 @@ static int string2ll(const char *s, size_t slen, long long *value) {
     return REDIS_OK;
 }
 
+/* Exact powers of ten, the largest a double holds without rounding. */
+static const double powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Convert a decimal into a double without strtod() when the result is known
+ * to be exact: with at most 15 significant digits the mantissa is an exact
+ * double, and scaling it by an exact power of ten up to 1e22 rounds once,
+ * which is the correctly rounded result strtod() would return (Clinger's fast
+ * path). Returns 0 when the string has to go through strtod(). */
+static int string2dFast(const char *s, size_t slen, double *value) {
+    const char *p = s, *end = s + slen;
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0, negative = 0;
+    double d;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    for (; p < end && (unsigned)(*p - '0') <= 9; p++, digits++)
+        mantissa = mantissa * 10 + (unsigned)(*p - '0');
+    if (p < end && *p == '.') {
+        for (p++; p < end && (unsigned)(*p - '0') <= 9; p++, digits++, exponent--)
+            mantissa = mantissa * 10 + (unsigned)(*p - '0');
+    }
+    if (digits == 0 || digits > 15)
+        return 0;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *start;
+        int e = 0, eneg = 0;
+
+        p++;
+        if (p < end && (*p == '-' || *p == '+')) {
+            eneg = *p == '-';
+            p++;
+        }
+        for (start = p; p < end && (unsigned)(*p - '0') <= 9 && e < 1000; p++)
+            e = e * 10 + (*p - '0');
+        if (p == start)
+            return 0;
+        exponent += eneg ? -e : e;
+    }
+    if (p != end || exponent < -22 || exponent > 22)
+        return 0;
+
+    d = (double)mantissa;
+    d = exponent < 0 ? d / powersOf10[-exponent] : d * powersOf10[exponent];
+    *value = negative ? -d : d;
+    return 1;
+}
+
 static char *readLine(redisReader *r, int *_len) {
     char *p, *s;
     int len;
@@ -307,7 +361,7 @@ static int processLineItem(redisReader *r) {
             } else if ((len == 3 && strcasecmp(buf,"nan") == 0) ||
                        (len == 4 && strcasecmp(buf, "-nan") == 0)) {
                 d = NAN; /* nan. */
-            } else {
+            } else if (!string2dFast(buf,len,&d)) {
                 d = strtod((char*)buf,&eptr);
                 /* RESP3 only allows "inf", "-inf", and finite values, while
                  * strtod() allows other variations on infinity,
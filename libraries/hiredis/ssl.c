@@ -530,8 +530,8 @@ static ssize_t redisSSLRead(redisContext *c, char *buf, size_t bufcap) {
 static ssize_t redisSSLWrite(redisContext *c) {
     redisSSL *rssl = c->privctx;
 
-    size_t len = rssl->lastLen ? rssl->lastLen : sdslen(c->obuf);
-    int rv = SSL_write(rssl->ssl, c->obuf, len);
+    size_t len = rssl->lastLen ? rssl->lastLen : sdslen(c->obuf) - c->obuf_pos;
+    int rv = SSL_write(rssl->ssl, c->obuf + c->obuf_pos, len);
 
     if (rv > 0) {
         rssl->lastLen = 0;
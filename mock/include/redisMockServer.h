@@ -0,0 +1,112 @@
+#ifndef REDIS_MOCK_SERVER_H
+#define REDIS_MOCK_SERVER_H
+
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fault injection for the mock server, can be changed while clients are connected
+struct RedisMockConfig
+{
+    std::chrono::microseconds latency{0};           // Delay before each batch of replies is sent
+    size_t fragmentSize = 0;                        // Split every write into chunks of this size, 0 sends it whole
+    std::chrono::microseconds fragmentDelay{0};     // Pause between chunks of a fragmented write
+    size_t readChunk = 0;                           // Read at most this much per recv, 0 reads up to 16K
+    std::chrono::microseconds readDelay{0};         // Pause after every recv, a slow consumer of client writes
+};
+
+struct RedisMockStats
+{
+    uint64_t connections = 0;
+    uint64_t commands = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t published = 0;         // Messages delivered to subscribers
+};
+
+// Embeddable RESP2/RESP3 server for tests and benchmarks that cannot reach Redis.
+//
+// Requests are parsed with the vendored hiredis reader, which reads a request array
+// exactly like a reply. Supports PING, ECHO, GET, SET, DEL, INCR, MGET, FLUSHALL,
+// PUBLISH, SPUBLISH, (P|S)SUBSCRIBE, (P|S)UNSUBSCRIBE, MULTI/EXEC/DISCARD, HELLO and
+// CLIENT TRACKING with invalidate pushes. Every connection is served by its own
+// thread; clients connect over loopback TCP on port() or through a socketpair from
+// connectPair().
+class RedisMockServer
+{
+
+public:
+
+    explicit RedisMockServer(RedisMockConfig config = RedisMockConfig());
+    ~RedisMockServer();
+
+    RedisMockServer(const RedisMockServer&) = delete;
+    RedisMockServer& operator=(const RedisMockServer&) = delete;
+
+    int port() const;
+
+    // Client end of a connected socketpair, hand it to redisConnectFd
+    int connectPair();
+
+    // Close every connection and stop accepting new ones
+    void stop();
+
+    void setConfig(RedisMockConfig config);
+    RedisMockConfig getConfig() const;
+    RedisMockStats stats() const;
+
+private:
+    struct Connection
+    {
+        int fd = -1;
+        bool resp3 = false;
+        bool tracking = false;
+        std::set<std::string> trackedKeys;
+        std::set<std::string> channels;
+        std::set<std::string> patterns;
+        std::set<std::string> shardChannels;
+        std::mutex writeMutex;
+    };
+
+    // Writes to other connections, sent once the keyspace lock is released
+    using Outbox = std::vector<std::pair<std::shared_ptr<Connection>, std::string>>;
+
+    int listener = -1;
+    int serverPort = 0;
+    std::atomic<bool> running{true};
+    std::thread acceptThread;
+
+    mutable std::mutex configMutex;
+    RedisMockConfig config;
+
+    // Keyspace, subscriptions and the connection list, all guarded by mutex
+    std::mutex mutex;
+    std::map<std::string, std::string> store;
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<std::thread> connectionThreads;
+
+    std::atomic<uint64_t> connectionCount{0};
+    std::atomic<uint64_t> commandCount{0};
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<uint64_t> publishedCount{0};
+
+    void acceptLoop();
+    void addConnection(int fd);
+    void serve(std::shared_ptr<Connection> connection);
+    std::string execute(Connection& connection, const std::vector<std::string>& argv, Outbox& outbox);
+    void invalidate(const std::string& key, Outbox& outbox);
+    void send(Connection& connection, const std::string& data);
+
+};
+
+#endif // REDIS_MOCK_SERVER_H
@@ -0,0 +1,473 @@
+#include "redisMockServer.h"
+
+// System Includes
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cstdlib>
+#include <fnmatch.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Project Includes
+#include <hiredis.h>
+
+namespace
+{
+    std::string bulk(const std::string& value)
+    {
+        return "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+    }
+
+    std::string integer(long long value)
+    {
+        return ":" + std::to_string(value) + "\r\n";
+    }
+
+    std::string nil(bool resp3)
+    {
+        return resp3 ? "_\r\n" : "$-1\r\n";
+    }
+
+    std::string header(char type, size_t count)
+    {
+        return type + std::to_string(count) + "\r\n";
+    }
+
+    // Out of band messages are pushes on RESP3 and plain arrays on RESP2
+    std::string pushHeader(bool resp3, size_t count)
+    {
+        return header(resp3 ? '>' : '*', count);
+    }
+
+    std::string error(const std::string& message)
+    {
+        return "-" + message + "\r\n";
+    }
+
+    std::string upper(std::string value)
+    {
+        std::transform(value.begin(), value.end(), value.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        return value;
+    }
+
+    // Confirmation for every name of a (P|S)SUBSCRIBE or (P|S)UNSUBSCRIBE, without names
+    // an unsubscribe drops all of them
+    std::string subscription(std::set<std::string>& names, const std::vector<std::string>& argv,
+                             const std::string& kind, bool add, bool resp3)
+    {
+        std::vector<std::string> targets(argv.begin() + 1, argv.end());
+        if (!add && targets.empty()) {
+            targets.assign(names.begin(), names.end());
+            if (targets.empty()) {
+                return pushHeader(resp3, 3) + bulk(kind) + nil(resp3) + integer(0);
+            }
+        }
+
+        std::string out;
+        for (const auto& target : targets) {
+            if (add) {
+                names.insert(target);
+            } else {
+                names.erase(target);
+            }
+            out += pushHeader(resp3, 3) + bulk(kind) + bulk(target) + integer(static_cast<long long>(names.size()));
+        }
+        return out;
+    }
+
+    template <typename Duration>
+    void pause(Duration duration)
+    {
+        if (duration.count() > 0) {
+            std::this_thread::sleep_for(duration);
+        }
+    }
+}
+
+RedisMockServer::RedisMockServer(RedisMockConfig config)
+    : config(config)
+{
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+
+    // Port 0 lets the kernel pick a free port, so parallel tests never collide
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 128) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        if (listener >= 0) {
+            close(listener);
+        }
+        throw std::runtime_error("Could not start Redis mock server");
+    }
+    serverPort = ntohs(address.sin_port);
+    acceptThread = std::thread(&RedisMockServer::acceptLoop, this);
+}
+
+RedisMockServer::~RedisMockServer()
+{
+    stop();
+}
+
+int RedisMockServer::port() const
+{
+    return serverPort;
+}
+
+void RedisMockServer::stop()
+{
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    shutdown(listener, SHUT_RDWR);
+    close(listener);
+    acceptThread.join();
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& connection : connections) {
+            shutdown(connection->fd, SHUT_RDWR);
+        }
+        threads.swap(connectionThreads);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+int RedisMockServer::connectPair()
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        throw std::runtime_error("Could not create mock server socketpair");
+    }
+    addConnection(fds[1]);
+    return fds[0];
+}
+
+void RedisMockServer::setConfig(RedisMockConfig config)
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    this->config = config;
+}
+
+RedisMockConfig RedisMockServer::getConfig() const
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    return config;
+}
+
+RedisMockStats RedisMockServer::stats() const
+{
+    RedisMockStats snapshot;
+    snapshot.connections = connectionCount.load(std::memory_order_relaxed);
+    snapshot.commands = commandCount.load(std::memory_order_relaxed);
+    snapshot.bytesIn = bytesIn.load(std::memory_order_relaxed);
+    snapshot.bytesOut = bytesOut.load(std::memory_order_relaxed);
+    snapshot.published = publishedCount.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void RedisMockServer::acceptLoop()
+{
+    while (running.load()) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        addConnection(fd);
+    }
+}
+
+void RedisMockServer::addConnection(int fd)
+{
+    auto connection = std::make_shared<Connection>();
+    connection->fd = fd;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running.load()) {
+        close(fd);
+        return;
+    }
+    connections.push_back(connection);
+    connectionThreads.emplace_back(&RedisMockServer::serve, this, connection);
+    connectionCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RedisMockServer::send(Connection& connection, const std::string& data)
+{
+    RedisMockConfig faults = getConfig();
+    size_t chunk = faults.fragmentSize > 0 ? faults.fragmentSize : data.size();
+
+    std::lock_guard<std::mutex> lock(connection.writeMutex);
+    if (connection.fd < 0) {
+        return; // Closed while the write was queued
+    }
+    size_t sent = 0;
+    while (sent < data.size()) {
+        if (sent > 0) {
+            pause(faults.fragmentDelay);
+        }
+        size_t length = std::min(chunk, data.size() - sent);
+        size_t written = 0;
+        while (written < length) {
+            ssize_t result = ::send(connection.fd, data.data() + sent + written, length - written, MSG_NOSIGNAL);
+            if (result <= 0) {
+                return;
+            }
+            written += static_cast<size_t>(result);
+        }
+        sent += length;
+        bytesOut.fetch_add(length, std::memory_order_relaxed);
+    }
+}
+
+void RedisMockServer::serve(std::shared_ptr<Connection> connection)
+{
+    redisReader* reader = redisReaderCreate();
+    std::vector<std::vector<std::string>> queued;
+    bool inMulti = false;
+    bool quit = false;
+    char buffer[16384];
+
+    while (!quit) {
+        RedisMockConfig faults = getConfig();
+        size_t capacity = faults.readChunk > 0 ? std::min(faults.readChunk, sizeof(buffer)) : sizeof(buffer);
+
+        ssize_t received = recv(connection->fd, buffer, capacity, 0);
+        if (received <= 0 || redisReaderFeed(reader, buffer, static_cast<size_t>(received)) != REDIS_OK) {
+            break;
+        }
+        bytesIn.fetch_add(static_cast<uint64_t>(received), std::memory_order_relaxed);
+        pause(faults.readDelay);
+
+        std::string out;
+        Outbox outbox;
+        void* parsed = nullptr;
+        while (!quit && redisReaderGetReply(reader, &parsed) == REDIS_OK && parsed != nullptr) {
+            redisReply* request = static_cast<redisReply*>(parsed);
+            std::vector<std::string> argv;
+            if (request->type == REDIS_REPLY_ARRAY) {
+                for (size_t i = 0; i < request->elements; ++i) {
+                    if (request->element[i]->str != nullptr) {
+                        argv.emplace_back(request->element[i]->str, request->element[i]->len);
+                    }
+                }
+            }
+            freeReplyObject(request);
+            if (argv.empty()) {
+                out += error("ERR Protocol error: expected a command array");
+                continue;
+            }
+            commandCount.fetch_add(1, std::memory_order_relaxed);
+
+            std::string name = upper(argv[0]);
+            if (name == "QUIT") {
+                out += "+OK\r\n";
+                quit = true;
+            } else if (name == "MULTI") {
+                out += inMulti ? error("ERR MULTI calls can not be nested") : "+OK\r\n";
+                inMulti = true;
+                queued.clear();
+            } else if (name == "DISCARD") {
+                out += inMulti ? "+OK\r\n" : error("ERR DISCARD without MULTI");
+                inMulti = false;
+                queued.clear();
+            } else if (name == "EXEC") {
+                if (!inMulti) {
+                    out += error("ERR EXEC without MULTI");
+                    continue;
+                }
+                inMulti = false;
+
+                // The whole transaction runs under one lock, no other client sees it half done
+                std::lock_guard<std::mutex> lock(mutex);
+                out += header('*', queued.size());
+                for (const auto& command : queued) {
+                    out += execute(*connection, command, outbox);
+                }
+                queued.clear();
+            } else if (inMulti) {
+                // Nothing runs until EXEC, so DISCARD leaves no trace
+                queued.push_back(std::move(argv));
+                out += "+QUEUED\r\n";
+            } else {
+                std::lock_guard<std::mutex> lock(mutex);
+                out += execute(*connection, argv, outbox);
+            }
+        }
+
+        for (auto& delivery : outbox) {
+            send(*delivery.first, delivery.second);
+        }
+        if (!out.empty()) {
+            pause(faults.latency);
+            send(*connection, out);
+        }
+        if (reader->err) {
+            break;
+        }
+    }
+
+    redisReaderFree(reader);
+
+    // Queued writes from other threads may still hold the connection, they see fd -1
+    std::lock_guard<std::mutex> lock(mutex);
+    connections.erase(std::remove(connections.begin(), connections.end(), connection), connections.end());
+    std::lock_guard<std::mutex> writeLock(connection->writeMutex);
+    close(connection->fd);
+    connection->fd = -1;
+}
+
+void RedisMockServer::invalidate(const std::string& key, Outbox& outbox)
+{
+    // Called with mutex held, tracking connections forget the key once told about it
+    for (auto& connection : connections) {
+        if (connection->tracking && connection->trackedKeys.erase(key) > 0) {
+            outbox.emplace_back(connection, pushHeader(true, 2) + bulk("invalidate") + header('*', 1) + bulk(key));
+        }
+    }
+}
+
+std::string RedisMockServer::execute(Connection& connection, const std::vector<std::string>& argv, Outbox& outbox)
+{
+    // Called with mutex held
+    std::string name = upper(argv[0]);
+    size_t argc = argv.size();
+
+    if (name == "PING") {
+        return argc > 1 ? bulk(argv[1]) : "+PONG\r\n";
+    }
+    if (name == "ECHO" && argc == 2) {
+        return bulk(argv[1]);
+    }
+    if (name == "GET" && argc == 2) {
+        if (connection.tracking) {
+            connection.trackedKeys.insert(argv[1]);
+        }
+        auto found = store.find(argv[1]);
+        return found == store.end() ? nil(connection.resp3) : bulk(found->second);
+    }
+    if (name == "MGET" && argc > 1) {
+        std::string out = header('*', argc - 1);
+        for (size_t i = 1; i < argc; ++i) {
+            if (connection.tracking) {
+                connection.trackedKeys.insert(argv[i]);
+            }
+            auto found = store.find(argv[i]);
+            out += found == store.end() ? nil(connection.resp3) : bulk(found->second);
+        }
+        return out;
+    }
+    if (name == "SET" && argc >= 3) {
+        store[argv[1]] = argv[2];
+        invalidate(argv[1], outbox);
+        return "+OK\r\n";
+    }
+    if (name == "DEL" && argc > 1) {
+        long long removed = 0;
+        for (size_t i = 1; i < argc; ++i) {
+            if (store.erase(argv[i]) > 0) {
+                ++removed;
+                invalidate(argv[i], outbox);
+            }
+        }
+        return integer(removed);
+    }
+    if (name == "INCR" && argc == 2) {
+        std::string& value = store[argv[1]];
+        char* end = nullptr;
+        long long current = value.empty() ? 0 : std::strtoll(value.c_str(), &end, 10);
+        if (!value.empty() && (end == nullptr || *end != '\0')) {
+            return error("ERR value is not an integer or out of range");
+        }
+        value = std::to_string(current + 1);
+        invalidate(argv[1], outbox);
+        return integer(current + 1);
+    }
+    if (name == "FLUSHALL") {
+        store.clear();
+        for (auto& other : connections) {
+            if (other->tracking) {
+                other->trackedKeys.clear();
+                outbox.emplace_back(other, pushHeader(true, 2) + bulk("invalidate") + nil(true));
+            }
+        }
+        return "+OK\r\n";
+    }
+    if (name == "PUBLISH" && argc == 3) {
+        long long receivers = 0;
+        for (auto& other : connections) {
+            if (other->channels.count(argv[1]) > 0) {
+                outbox.emplace_back(other, pushHeader(other->resp3, 3) + bulk("message") + bulk(argv[1]) + bulk(argv[2]));
+                ++receivers;
+            }
+            for (const auto& pattern : other->patterns) {
+                if (fnmatch(pattern.c_str(), argv[1].c_str(), 0) == 0) {
+                    outbox.emplace_back(other, pushHeader(other->resp3, 4) + bulk("pmessage") + bulk(pattern) +
+                                               bulk(argv[1]) + bulk(argv[2]));
+                    ++receivers;
+                }
+            }
+        }
+        publishedCount.fetch_add(static_cast<uint64_t>(receivers), std::memory_order_relaxed);
+        return integer(receivers);
+    }
+    if (name == "SPUBLISH" && argc == 3) {
+        long long receivers = 0;
+        for (auto& other : connections) {
+            if (other->shardChannels.count(argv[1]) > 0) {
+                outbox.emplace_back(other, pushHeader(other->resp3, 3) + bulk("smessage") + bulk(argv[1]) + bulk(argv[2]));
+                ++receivers;
+            }
+        }
+        publishedCount.fetch_add(static_cast<uint64_t>(receivers), std::memory_order_relaxed);
+        return integer(receivers);
+    }
+    if ((name == "SUBSCRIBE" || name == "PSUBSCRIBE" || name == "SSUBSCRIBE") && argc > 1) {
+        std::set<std::string>& names = name[0] == 'P' ? connection.patterns :
+                                       name[0] == 'S' && name[1] == 'S' ? connection.shardChannels :
+                                       connection.channels;
+        std::string kind = name == "SUBSCRIBE" ? "subscribe" : name[0] == 'P' ? "psubscribe" : "ssubscribe";
+        return subscription(names, argv, kind, true, connection.resp3);
+    }
+    if (name == "UNSUBSCRIBE" || name == "PUNSUBSCRIBE" || name == "SUNSUBSCRIBE") {
+        std::set<std::string>& names = name[0] == 'P' ? connection.patterns :
+                                       name[0] == 'S' ? connection.shardChannels :
+                                       connection.channels;
+        std::string kind = name == "UNSUBSCRIBE" ? "unsubscribe" : name[0] == 'P' ? "punsubscribe" : "sunsubscribe";
+        return subscription(names, argv, kind, false, connection.resp3);
+    }
+    if (name == "HELLO") {
+        int protocol = argc > 1 ? std::atoi(argv[1].c_str()) : (connection.resp3 ? 3 : 2);
+        if (protocol != 2 && protocol != 3) {
+            return error("NOPROTO unsupported protocol version");
+        }
+        connection.resp3 = protocol == 3;
+        return header(connection.resp3 ? '%' : '*', connection.resp3 ? 3 : 6) +
+               bulk("server") + bulk("redis") + bulk("version") + bulk("7.0.0") +
+               bulk("proto") + integer(protocol);
+    }
+    if (name == "CLIENT" && argc >= 3 && upper(argv[1]) == "TRACKING") {
+        if (!connection.resp3) {
+            return error("ERR the mock server only supports tracking on RESP3 connections");
+        }
+        connection.tracking = upper(argv[2]) == "ON";
+        connection.trackedKeys.clear();
+        return "+OK\r\n";
+    }
+
+    return error("ERR unknown command '" + argv[0] + "'");
+}
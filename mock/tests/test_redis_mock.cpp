@@ -0,0 +1,149 @@
+// System Includes
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <poll.h>
+#include <string>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisMockServer.h"
+
+// Checks the mock server answers the way Redis does, so tests and benchmarks built on
+// it measure the client and not a quirk of the mock. Every check runs, the exit code
+// is non-zero when any of them failed.
+
+namespace
+{
+    using ContextPtr = std::unique_ptr<redisContext, void (*)(redisContext*)>;
+    using ReplyPtr = std::unique_ptr<redisReply, void (*)(void*)>;
+
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    ContextPtr connect(RedisMockServer& server)
+    {
+        ContextPtr context(redisConnect("127.0.0.1", server.port()), redisFree);
+        if (context == nullptr || context->err) {
+            std::fprintf(stderr, "Could not connect to the mock server\n");
+            std::exit(1);
+        }
+        return context;
+    }
+
+    ReplyPtr command(redisContext* context, const char* format, ...)
+    {
+        va_list arguments;
+        va_start(arguments, format);
+        void* reply = redisvCommand(context, format, arguments);
+        va_end(arguments);
+        return ReplyPtr(static_cast<redisReply*>(reply), freeReplyObject);
+    }
+
+    bool isString(const redisReply* reply, const char* value)
+    {
+        return reply != nullptr && reply->str != nullptr && std::string(reply->str, reply->len) == value;
+    }
+
+    bool isNil(const redisReply* reply)
+    {
+        return reply != nullptr && reply->type == REDIS_REPLY_NIL;
+    }
+
+    // Messages sent to a subscriber within 50ms, the socket is only read when readable
+    size_t pendingMessages(redisContext* subscriber)
+    {
+        pollfd readable = {subscriber->fd, POLLIN, 0};
+        if (poll(&readable, 1, 50) > 0) {
+            redisBufferRead(subscriber);
+        }
+        size_t count = 0;
+        void* reply = nullptr;
+        while (redisGetReplyFromReader(subscriber, &reply) == REDIS_OK && reply != nullptr) {
+            freeReplyObject(reply);
+            ++count;
+        }
+        return count;
+    }
+
+    void transactionRunsOnExec(RedisMockServer& server)
+    {
+        ContextPtr client = connect(server);
+        ContextPtr other = connect(server);
+
+        check(isString(command(client.get(), "MULTI").get(), "OK"), "MULTI answers OK");
+        check(isString(command(client.get(), "SET tx:key queued").get(), "QUEUED"), "SET inside MULTI is queued");
+        check(isNil(command(other.get(), "GET tx:key").get()), "queued SET has not run before EXEC");
+
+        ReplyPtr results = command(client.get(), "EXEC");
+        check(results && results->type == REDIS_REPLY_ARRAY && results->elements == 1 &&
+              isString(results->element[0], "OK"), "EXEC returns the SET reply");
+        check(isString(command(other.get(), "GET tx:key").get(), "queued"), "SET has run after EXEC");
+    }
+
+    void discardLeavesNoTrace(RedisMockServer& server)
+    {
+        ContextPtr client = connect(server);
+        ContextPtr subscriber = connect(server);
+        command(subscriber.get(), "SUBSCRIBE tx:channel");
+        uint64_t published = server.stats().published;
+
+        command(client.get(), "MULTI");
+        command(client.get(), "SET tx:discarded value");
+        check(isString(command(client.get(), "PUBLISH tx:channel message").get(), "QUEUED"),
+              "PUBLISH inside MULTI is queued");
+        check(pendingMessages(subscriber.get()) == 0, "queued PUBLISH is not delivered before EXEC");
+        check(isString(command(client.get(), "DISCARD").get(), "OK"), "DISCARD answers OK");
+
+        check(isNil(command(client.get(), "GET tx:discarded").get()), "discarded SET never runs");
+        check(pendingMessages(subscriber.get()) == 0, "discarded PUBLISH is never delivered");
+        check(server.stats().published == published, "discarded PUBLISH is not counted");
+
+        ReplyPtr error = command(client.get(), "EXEC");
+        check(error && error->type == REDIS_REPLY_ERROR, "EXEC after DISCARD is an error");
+
+        command(client.get(), "MULTI");
+        command(client.get(), "PUBLISH tx:channel message");
+        command(client.get(), "EXEC");
+        check(pendingMessages(subscriber.get()) == 1, "PUBLISH is delivered on EXEC");
+    }
+
+    void fragmentedReplies(RedisMockServer& server)
+    {
+        RedisMockConfig faults;
+        faults.fragmentSize = 3;
+        faults.fragmentDelay = std::chrono::microseconds(100);
+        faults.readChunk = 5;
+        server.setConfig(faults);
+
+        ContextPtr client = connect(server);
+        command(client.get(), "SET fragment:key %s", "a value split over many writes");
+        check(isString(command(client.get(), "GET fragment:key").get(), "a value split over many writes"),
+              "fragmented reply reassembles");
+        server.setConfig(RedisMockConfig());
+    }
+}
+
+int main()
+{
+    RedisMockServer server;
+    transactionRunsOnExec(server);
+    discardLeavesNoTrace(server);
+    fragmentedReplies(server);
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d mock server checks failed\n", failures);
+        return 1;
+    }
+    std::printf("All mock server checks passed\n");
+    return 0;
+}
@@ -0,0 +1,519 @@
+#include "redisAllocator.h"
+
+// System Includes
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+
+namespace
+{
+    // Every block starts with a header so free() knows its class, it is as large as
+    // malloc's alignment to keep payloads aligned the same way
+    struct Header
+    {
+        uint32_t sizeClass;
+        uint32_t unused;
+        uint64_t size;                  // Usable bytes after the header
+    };
+    static_assert(sizeof(Header) == alignof(std::max_align_t), "Header keeps malloc alignment");
+
+    // Tuned to hiredis: reply nodes, read tasks and short sds strings are 16 to 64 bytes
+    constexpr size_t classCount = 24;
+    constexpr std::array<size_t, classCount> classSizes = {
+        16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+        320, 384, 448, 512, 640, 768, 896, 1024, 1280, 1536, 1792, 2048
+    };
+    constexpr size_t maxSmall = 2048;
+    constexpr uint32_t largeClass = UINT32_MAX;
+
+    // Size class of every request up to maxSmall, in steps of 16 bytes
+    constexpr std::array<uint8_t, maxSmall / 16 + 1> classLookup = [] {
+        std::array<uint8_t, maxSmall / 16 + 1> lookup{};
+        size_t sizeClass = 0;
+        for (size_t step = 0; step < lookup.size(); ++step) {
+            while (classSizes[sizeClass] < step * 16) {
+                ++sizeClass;
+            }
+            lookup[step] = static_cast<uint8_t>(sizeClass);
+        }
+        return lookup;
+    }();
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct CentralList
+    {
+        std::mutex mutex;
+        FreeBlock* head = nullptr;
+        size_t length = 0;
+        std::vector<char*> slabs;       // Every slab carved for this class, for trim()
+    };
+
+    // Counters are only written by the owning thread, so they are plain stores that
+    // metrics() can read from any thread
+    struct ThreadCache
+    {
+        std::array<FreeBlock*, classCount> heads{};
+        std::array<size_t, classCount> lengths{};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<uint64_t> allocatedBytes{0};
+        std::atomic<uint64_t> freedBytes{0};
+    };
+
+    // Lives for the rest of the process once installed, hiredis may still free blocks
+    // from static destructors
+    struct Pool
+    {
+        RedisAllocatorConfig config;
+        std::array<CentralList, classCount> central;
+        std::chrono::steady_clock::time_point installedAt;
+
+        std::mutex registryMutex;
+        std::vector<ThreadCache*> caches;
+
+        // Counters of exited threads, and of threads allocating after their cache is gone
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<uint64_t> allocatedBytes{0};
+        std::atomic<uint64_t> freedBytes{0};
+        std::atomic<uint64_t> reservedBytes{0};
+    };
+
+    Pool* pool = nullptr;
+    std::mutex installMutex;
+
+    void bump(std::atomic<uint64_t>& counter, uint64_t amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    size_t classOf(size_t size)
+    {
+        return classLookup[(size + 15) >> 4];
+    }
+
+    size_t blockSizeOf(size_t sizeClass)
+    {
+        return sizeof(Header) + classSizes[sizeClass];
+    }
+
+    size_t slabSizeOf(size_t sizeClass)
+    {
+        return std::max(pool->config.slabSize, blockSizeOf(sizeClass) * 8);
+    }
+
+    // Pushes a chain of blocks onto a shared list
+    void release(size_t sizeClass, FreeBlock* first, FreeBlock* last, size_t count)
+    {
+        CentralList& list = pool->central[sizeClass];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        last->next = list.head;
+        list.head = first;
+        list.length += count;
+    }
+
+    // Takes up to count blocks from a shared list, carving a new slab when it is empty
+    FreeBlock* acquire(size_t sizeClass, size_t count, size_t& taken)
+    {
+        CentralList& list = pool->central[sizeClass];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        if (list.head == nullptr) {
+            size_t blockSize = blockSizeOf(sizeClass);
+            size_t slabSize = slabSizeOf(sizeClass);
+            char* slab = static_cast<char*>(std::malloc(slabSize));
+            if (slab == nullptr) {
+                taken = 0;
+                return nullptr;
+            }
+            list.slabs.push_back(slab);
+            pool->reservedBytes.fetch_add(slabSize, std::memory_order_relaxed);
+            for (size_t offset = 0; offset + blockSize <= slabSize; offset += blockSize) {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+                block->next = list.head;
+                list.head = block;
+                ++list.length;
+            }
+        }
+
+        FreeBlock* first = list.head;
+        FreeBlock* last = first;
+        taken = 1;
+        while (taken < count && last->next != nullptr) {
+            last = last->next;
+            ++taken;
+        }
+        list.head = last->next;
+        list.length -= taken;
+        last->next = nullptr;
+        return first;
+    }
+
+    // Hands every block cached by the calling thread to the shared lists
+    void flushCache(ThreadCache* cache)
+    {
+        for (size_t sizeClass = 0; sizeClass < classCount; ++sizeClass) {
+            FreeBlock* first = cache->heads[sizeClass];
+            if (first != nullptr) {
+                FreeBlock* last = first;
+                while (last->next != nullptr) {
+                    last = last->next;
+                }
+                release(sizeClass, first, last, cache->lengths[sizeClass]);
+                cache->heads[sizeClass] = nullptr;
+                cache->lengths[sizeClass] = 0;
+            }
+        }
+    }
+
+    // Hands the cache's blocks and counters back to the pool when its thread exits
+    struct CacheOwner
+    {
+        ThreadCache* cache = nullptr;
+        ~CacheOwner();
+    };
+
+    // Only trivial thread locals are read on the hot path, the owner is touched once
+    thread_local ThreadCache* current = nullptr;
+    thread_local bool exited = false;
+    thread_local CacheOwner owner;
+
+    CacheOwner::~CacheOwner()
+    {
+        if (cache == nullptr) {
+            return;
+        }
+        current = nullptr;
+        exited = true;
+        flushCache(cache);
+        {
+            std::lock_guard<std::mutex> lock(pool->registryMutex);
+            pool->caches.erase(std::remove(pool->caches.begin(), pool->caches.end(), cache), pool->caches.end());
+            pool->allocations.fetch_add(cache->allocations.load(), std::memory_order_relaxed);
+            pool->frees.fetch_add(cache->frees.load(), std::memory_order_relaxed);
+            pool->allocatedBytes.fetch_add(cache->allocatedBytes.load(), std::memory_order_relaxed);
+            pool->freedBytes.fetch_add(cache->freedBytes.load(), std::memory_order_relaxed);
+        }
+        delete cache;
+        cache = nullptr;
+    }
+
+    // First allocation on a thread, or one made after its cache was handed back
+    ThreadCache* attachCache()
+    {
+        if (exited) {
+            return nullptr;
+        }
+        ThreadCache* cache = new ThreadCache();
+        {
+            std::lock_guard<std::mutex> lock(pool->registryMutex);
+            pool->caches.push_back(cache);
+        }
+        owner.cache = cache;
+        current = cache;
+        return cache;
+    }
+
+    inline ThreadCache* threadCache()
+    {
+        return current != nullptr ? current : attachCache();
+    }
+
+    // Frees the slabs of one class whose blocks are all on its shared list
+    size_t trimClass(size_t sizeClass)
+    {
+        CentralList& list = pool->central[sizeClass];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        if (list.slabs.empty()) {
+            return 0;
+        }
+        size_t slabSize = slabSizeOf(sizeClass);
+        size_t perSlab = slabSize / blockSizeOf(sizeClass);
+        std::sort(list.slabs.begin(), list.slabs.end());
+        auto slabOf = [&list](const FreeBlock* block) {
+            const char* address = reinterpret_cast<const char*>(block);
+            return std::upper_bound(list.slabs.begin(), list.slabs.end(), address,
+                                    std::less<const char*>()) - list.slabs.begin() - 1;
+        };
+
+        std::vector<size_t> freeBlocks(list.slabs.size(), 0);
+        for (FreeBlock* block = list.head; block != nullptr; block = block->next) {
+            ++freeBlocks[slabOf(block)];
+        }
+
+        // Blocks of the slabs going away are unlinked before the slabs are freed
+        FreeBlock** link = &list.head;
+        while (*link != nullptr) {
+            if (freeBlocks[slabOf(*link)] == perSlab) {
+                *link = (*link)->next;
+                --list.length;
+            } else {
+                link = &(*link)->next;
+            }
+        }
+
+        size_t kept = 0;
+        size_t released = 0;
+        for (size_t i = 0; i < list.slabs.size(); ++i) {
+            if (freeBlocks[i] == perSlab) {
+                std::free(list.slabs[i]);
+                released += slabSize;
+            } else {
+                list.slabs[kept++] = list.slabs[i];
+            }
+        }
+        list.slabs.resize(kept);
+        pool->reservedBytes.fetch_sub(released, std::memory_order_relaxed);
+        return released;
+    }
+
+    void* finish(FreeBlock* block, size_t sizeClass, ThreadCache* cache)
+    {
+        Header* header = reinterpret_cast<Header*>(block);
+        header->sizeClass = static_cast<uint32_t>(sizeClass);
+        header->size = classSizes[sizeClass];
+        if (cache != nullptr) {
+            bump(cache->allocations, 1);
+            bump(cache->allocatedBytes, header->size);
+        } else {
+            pool->allocations.fetch_add(1, std::memory_order_relaxed);
+            pool->allocatedBytes.fetch_add(header->size, std::memory_order_relaxed);
+        }
+        return header + 1;
+    }
+
+    void* allocateLarge(size_t size)
+    {
+        Header* header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+        if (header == nullptr) {
+            return nullptr;
+        }
+        header->sizeClass = largeClass;
+        header->size = size;
+        ThreadCache* cache = threadCache();
+        if (cache != nullptr) {
+            bump(cache->allocations, 1);
+            bump(cache->allocatedBytes, size);
+        } else {
+            pool->allocations.fetch_add(1, std::memory_order_relaxed);
+            pool->allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+        return header + 1;
+    }
+
+    void* poolMalloc(size_t size)
+    {
+        if (size > maxSmall) {
+            return allocateLarge(size);
+        }
+        size_t sizeClass = classOf(size);
+        ThreadCache* cache = threadCache();
+        if (cache == nullptr) {
+            size_t taken = 0;
+            FreeBlock* block = acquire(sizeClass, 1, taken);
+            return block ? finish(block, sizeClass, nullptr) : nullptr;
+        }
+
+        FreeBlock* block = cache->heads[sizeClass];
+        if (block == nullptr) {
+            size_t taken = 0;
+            block = acquire(sizeClass, std::max<size_t>(pool->config.threadCacheBlocks / 2, 1), taken);
+            if (block == nullptr) {
+                return nullptr;
+            }
+            cache->lengths[sizeClass] = taken;
+        }
+        cache->heads[sizeClass] = block->next;
+        --cache->lengths[sizeClass];
+        return finish(block, sizeClass, cache);
+    }
+
+    void poolFree(void* pointer)
+    {
+        if (pointer == nullptr) {
+            return;
+        }
+        Header* header = static_cast<Header*>(pointer) - 1;
+        ThreadCache* cache = threadCache();
+        if (cache != nullptr) {
+            bump(cache->frees, 1);
+            bump(cache->freedBytes, header->size);
+        } else {
+            pool->frees.fetch_add(1, std::memory_order_relaxed);
+            pool->freedBytes.fetch_add(header->size, std::memory_order_relaxed);
+        }
+
+        if (header->sizeClass == largeClass) {
+            std::free(header);
+            return;
+        }
+        size_t sizeClass = header->sizeClass;
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
+        if (cache == nullptr) {
+            release(sizeClass, block, block, 1);
+            return;
+        }
+
+        block->next = cache->heads[sizeClass];
+        cache->heads[sizeClass] = block;
+        // A thread that only frees would otherwise hoard every block it is handed
+        if (++cache->lengths[sizeClass] > std::max<size_t>(pool->config.threadCacheBlocks, 1)) {
+            size_t count = cache->lengths[sizeClass] / 2;
+            FreeBlock* last = block;
+            for (size_t i = 1; i < count; ++i) {
+                last = last->next;
+            }
+            cache->heads[sizeClass] = last->next;
+            cache->lengths[sizeClass] -= count;
+            release(sizeClass, block, last, count);
+        }
+    }
+
+    void* poolCalloc(size_t count, size_t size)
+    {
+        // hi_calloc has already checked the product for overflow
+        void* pointer = poolMalloc(count * size);
+        if (pointer != nullptr) {
+            std::memset(pointer, 0, count * size);
+        }
+        return pointer;
+    }
+
+    void* poolRealloc(void* pointer, size_t size)
+    {
+        if (pointer == nullptr) {
+            return poolMalloc(size);
+        }
+        Header* header = static_cast<Header*>(pointer) - 1;
+
+        // A block already large enough is kept unless it would be mostly empty
+        if (header->sizeClass != largeClass && size <= header->size && size * 2 > header->size) {
+            return pointer;
+        }
+        if (header->sizeClass == largeClass && size > maxSmall) {
+            size_t previous = header->size;
+            Header* moved = static_cast<Header*>(std::realloc(header, sizeof(Header) + size));
+            if (moved == nullptr) {
+                return nullptr;
+            }
+            moved->size = size;
+            ThreadCache* cache = threadCache();
+            if (cache != nullptr) {
+                bump(cache->allocatedBytes, size);
+                bump(cache->freedBytes, previous);
+            } else {
+                pool->allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+                pool->freedBytes.fetch_add(previous, std::memory_order_relaxed);
+            }
+            return moved + 1;
+        }
+
+        void* resized = poolMalloc(size);
+        if (resized == nullptr) {
+            return nullptr;
+        }
+        std::memcpy(resized, pointer, std::min<size_t>(size, header->size));
+        poolFree(pointer);
+        return resized;
+    }
+
+    char* poolStrdup(const char* string)
+    {
+        size_t length = std::strlen(string) + 1;
+        char* copy = static_cast<char*>(poolMalloc(length));
+        if (copy != nullptr) {
+            std::memcpy(copy, string, length);
+        }
+        return copy;
+    }
+}
+
+void RedisAllocator::install(RedisAllocatorConfig config)
+{
+    std::lock_guard<std::mutex> lock(installMutex);
+    if (pool != nullptr) {
+        return;
+    }
+    if (hiredisAllocFns.mallocFn != &std::malloc || hiredisAllocFns.freeFn != &std::free) {
+        throw std::runtime_error("hiredis already uses another allocator");
+    }
+
+    Pool* created = new Pool();
+    created->config = config;
+    created->installedAt = std::chrono::steady_clock::now();
+    pool = created;
+
+    hiredisAllocFuncs functions = {poolMalloc, poolCalloc, poolRealloc, poolStrdup, poolFree};
+    hiredisSetAllocators(&functions);
+}
+
+size_t RedisAllocator::trim()
+{
+    {
+        std::lock_guard<std::mutex> lock(installMutex);
+        if (pool == nullptr) {
+            return 0;
+        }
+    }
+    if (current != nullptr) {
+        flushCache(current);
+    }
+    size_t released = 0;
+    for (size_t sizeClass = 0; sizeClass < classCount; ++sizeClass) {
+        released += trimClass(sizeClass);
+    }
+    return released;
+}
+
+bool RedisAllocator::installed()
+{
+    std::lock_guard<std::mutex> lock(installMutex);
+    return pool != nullptr;
+}
+
+RedisAllocatorMetrics RedisAllocator::metrics()
+{
+    RedisAllocatorMetrics snapshot;
+    {
+        std::lock_guard<std::mutex> lock(installMutex);
+        if (pool == nullptr) {
+            return snapshot;
+        }
+    }
+
+    uint64_t allocatedBytes = 0;
+    uint64_t freedBytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(pool->registryMutex);
+        snapshot.allocations = pool->allocations.load(std::memory_order_relaxed);
+        snapshot.frees = pool->frees.load(std::memory_order_relaxed);
+        allocatedBytes = pool->allocatedBytes.load(std::memory_order_relaxed);
+        freedBytes = pool->freedBytes.load(std::memory_order_relaxed);
+        for (const ThreadCache* cache : pool->caches) {
+            snapshot.allocations += cache->allocations.load(std::memory_order_relaxed);
+            snapshot.frees += cache->frees.load(std::memory_order_relaxed);
+            allocatedBytes += cache->allocatedBytes.load(std::memory_order_relaxed);
+            freedBytes += cache->freedBytes.load(std::memory_order_relaxed);
+        }
+    }
+    // Frees are counted by the freeing thread, a snapshot can catch one before its allocation
+    snapshot.liveBytes = allocatedBytes > freedBytes ? allocatedBytes - freedBytes : 0;
+    snapshot.reservedBytes = pool->reservedBytes.load(std::memory_order_relaxed);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pool->installedAt).count();
+    snapshot.allocationsPerSecond = seconds > 0 ? snapshot.allocations / seconds : 0;
+    return snapshot;
+}
@@ -0,0 +1,258 @@
+#include "redisAutoPipeline.h"
+
+// System Includes
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+
+RedisAutoPipeline::RedisAutoPipeline(const RedisEndpoint& address, RedisAutoPipelineConfig config,
+                                     RedisReconnectConfig reconnect)
+    : config(config), queue(config.queueCapacity),
+      reconnector(std::make_unique<RedisReconnector>(reconnect)), target(address)
+{
+    context = redisConnect(address.host.c_str(), address.port);
+    if (context == nullptr || context->err) {
+        redisFree(context);
+        throw std::runtime_error("Could not connect to Redis auto pipeline");
+    }
+    redisSetOutputBufferRetention(context, REDIS_OBUF_MAX_RETAIN);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        redisFree(context);
+        throw std::runtime_error("Could not create auto pipeline wake up descriptor");
+    }
+    running.store(true);
+    ioThread = std::thread(&RedisAutoPipeline::ioLoop, this);
+}
+
+RedisAutoPipeline::~RedisAutoPipeline()
+{
+    // Commands already queued are still answered before the I/O thread exits
+    running.store(false);
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+    ioThread.join();
+    close(wakeFd);
+    redisFree(context);
+}
+
+redisReply* RedisAutoPipeline::execute(std::string_view formatted)
+{
+    return execute(formatted, 1);
+}
+
+redisReply* RedisAutoPipeline::execute(std::string_view formatted, size_t commands)
+{
+    Waiter waiter;
+    if (!queue.tryPush(Request{formatted.data(), formatted.size(), &waiter, commands})) {
+        rejected.fetch_add(commands, std::memory_order_relaxed);
+        throw std::runtime_error("Auto pipeline queue is full");
+    }
+    submitted.fetch_add(commands, std::memory_order_relaxed);
+
+    // Pairs with the fence in ioLoop, either the I/O thread sees the new command or we
+    // see it going to sleep, only the first caller to see that pays for the wake up
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+        wake();
+    }
+
+    std::unique_lock<std::mutex> lock(waiter.mutex);
+    waiter.answered.wait(lock, [&waiter]() { return waiter.finished; });
+    if (waiter.reply == nullptr) {
+        throw std::runtime_error(waiter.error);
+    }
+    return waiter.reply;
+}
+
+void RedisAutoPipeline::moveTo(const RedisEndpoint& endpoint)
+{
+    {
+        std::lock_guard<std::mutex> lock(targetMutex);
+        if (endpoint.host == target.host && endpoint.port == target.port) {
+            return;
+        }
+        target = endpoint;
+        targetGeneration.fetch_add(1, std::memory_order_release);
+    }
+    wake();
+}
+
+void RedisAutoPipeline::wake()
+{
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+void RedisAutoPipeline::complete(Waiter* waiter, redisReply* reply, const char* error)
+{
+    // Notified under the lock, the caller may return and destroy the waiter as soon as
+    // it can see the result
+    std::lock_guard<std::mutex> lock(waiter->mutex);
+    waiter->reply = reply;
+    if (error != nullptr) {
+        waiter->error = error;
+    }
+    waiter->finished = true;
+    waiter->answered.notify_one();
+}
+
+void RedisAutoPipeline::ioLoop()
+{
+    const size_t maxBatch = std::max<size_t>(config.maxBatch, 1);
+    uint64_t generation = targetGeneration.load(std::memory_order_acquire);
+    std::deque<Waiter*> inFlight;
+    Request request;
+    bool connected = true;
+
+    for (;;) {
+        // Commands sent on a connection that then failed may or may not have run, they
+        // are failed rather than sent twice
+        if (context->err && connected) {
+            spdlog::warn("Auto pipeline connection lost: {}", context->errstr);
+            connected = false;
+        }
+        while (context->err && !inFlight.empty()) {
+            Waiter* waiter = inFlight.front();
+            inFlight.pop_front();
+            failed.fetch_add(1, std::memory_order_relaxed);
+            if (inFlight.empty() || inFlight.front() != waiter) {
+                complete(waiter, nullptr, context->errstr);
+            }
+        }
+
+        // A moved server takes over once the old connection has answered what it was sent
+        bool moved = targetGeneration.load(std::memory_order_acquire) != generation;
+        if (context->err || (moved && inFlight.empty())) {
+            if (!restore(generation)) {
+                // Nothing can be sent for now, fail what is waiting rather than hold it
+                while (queue.tryPop(request)) {
+                    failed.fetch_add(request.commands, std::memory_order_relaxed);
+                    complete(request.waiter, nullptr, "Redis connection lost, reconnect pending");
+                }
+                if (!running.load()) {
+                    break;
+                }
+
+                // Tried again once a caller queues more or the server moves
+                idle(-1, true);
+                continue;
+            }
+            connected = true;
+            moved = false;
+        }
+
+        // Everything queued since the last write goes out in one write, a request of
+        // several commands waits on one reply for each
+        size_t appended = 0;
+        while (!moved && appended < maxBatch && queue.tryPop(request)) {
+            if (redisAppendFormattedCommand(context, request.data, request.length) != REDIS_OK) {
+                failed.fetch_add(request.commands, std::memory_order_relaxed);
+                complete(request.waiter, nullptr, "Failed to queue command");
+                continue;
+            }
+            inFlight.insert(inFlight.end(), request.commands, request.waiter);
+            appended += request.commands;
+        }
+        if (appended > 0) {
+            flushes.fetch_add(1, std::memory_order_relaxed);
+            int done = 0;
+            while (!done && redisBufferWrite(context, &done) == REDIS_OK) {
+            }
+        }
+
+        // Replies come back in the order the commands were written
+        while (!inFlight.empty() && !context->err) {
+            void* reply = nullptr;
+            if (redisGetReplyFromReader(context, &reply) != REDIS_OK || reply == nullptr) {
+                break;
+            }
+            Waiter* waiter = inFlight.front();
+            inFlight.pop_front();
+            completed.fetch_add(1, std::memory_order_relaxed);
+
+            // Only the last reply of a request is handed back, once the caller is
+            // answered it may destroy the waiter
+            if (!inFlight.empty() && inFlight.front() == waiter) {
+                freeReplyObject(reply);
+                continue;
+            }
+            complete(waiter, static_cast<redisReply*>(reply), nullptr);
+        }
+
+        if (context->err || (!queue.empty() && !moved)) {
+            continue;
+        }
+        if (!running.load() && inFlight.empty()) {
+            break;
+        }
+
+        // Wait for replies or for a caller to queue more. A readable socket with nothing
+        // in flight is the server closing it, which the read turns into an error
+        if (idle(context->fd, !moved)) {
+            redisBufferRead(context);
+        }
+    }
+}
+
+bool RedisAutoPipeline::idle(int fd, bool queued)
+{
+    pollfd watched[2] = {{wakeFd, POLLIN, 0}, {fd, POLLIN, 0}};
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!queued || queue.empty()) {
+        poll(watched, fd < 0 ? 1 : 2, -1);
+    }
+    sleeping.store(false, std::memory_order_relaxed);
+
+    if (watched[0].revents & POLLIN) {
+        uint64_t wakes = 0;
+        ssize_t drained = read(wakeFd, &wakes, sizeof(wakes));
+        (void)drained;
+    }
+    return fd >= 0 && (watched[1].revents & (POLLIN | POLLHUP | POLLERR));
+}
+
+bool RedisAutoPipeline::restore(uint64_t& generation)
+{
+    // Backoff is cut short by stopping or by a move, which is then tried straight away
+    RedisEndpoint endpoint;
+    {
+        std::lock_guard<std::mutex> lock(targetMutex);
+        endpoint = target;
+        generation = targetGeneration.load(std::memory_order_acquire);
+    }
+    RedisReconnector::retarget(context, endpoint);
+    bool restored = reconnector->reconnect(context, [this, generation]() {
+        return running.load() && targetGeneration.load(std::memory_order_acquire) == generation;
+    });
+    if (restored) {
+        spdlog::info("Auto pipeline connected to {}:{}", endpoint.host, endpoint.port);
+    }
+    return restored;
+}
+
+RedisAutoPipelineMetrics RedisAutoPipeline::metrics() const
+{
+    RedisAutoPipelineMetrics snapshot;
+    snapshot.submitted = submitted.load(std::memory_order_relaxed);
+    snapshot.completed = completed.load(std::memory_order_relaxed);
+    snapshot.failed = failed.load(std::memory_order_relaxed);
+    snapshot.rejected = rejected.load(std::memory_order_relaxed);
+    snapshot.flushes = flushes.load(std::memory_order_relaxed);
+    snapshot.queueDepth = queue.size();
+    return snapshot;
+}
+
+RedisReconnectMetrics RedisAutoPipeline::reconnectMetrics() const
+{
+    return reconnector->metrics();
+}
@@ -1,50 +1,454 @@
 #include "redisClient.h"
 
 // System Includes
+#include <algorithm>
+#include <charconv>
 #include <stdexcept>
 #include <string.h>
+#include <cctype>
 #include <cstring>
-#include <sstream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    // Argument of a RESP encoded request, "*N\r\n$len\r\nNAME\r\n$len\r\nKEY\r\n..."
+    std::string_view formattedArgument(std::string_view formatted, size_t index)
+    {
+        size_t position = formatted.find("\r\n");
+        for (size_t i = 0; position != std::string_view::npos; ++i) {
+            position += 2;
+            if (position >= formatted.size() || formatted[position] != '$') {
+                break;
+            }
+            size_t lengthEnd = formatted.find("\r\n", position);
+            if (lengthEnd == std::string_view::npos) {
+                break;
+            }
+            size_t length = 0;
+            std::from_chars(formatted.data() + position + 1, formatted.data() + lengthEnd, length);
+            size_t start = lengthEnd + 2;
+            if (start + length > formatted.size()) {
+                break;
+            }
+            if (i == index) {
+                return formatted.substr(start, length);
+            }
+            position = start + length;
+        }
+        return std::string_view();
+    }
+
+    // Command name of a RESP encoded request
+    std::string_view formattedName(std::string_view formatted)
+    {
+        return formattedArgument(formatted, 0);
+    }
+
+    const char* subscriptionCommand(SubscriptionKind kind, bool add)
+    {
+        switch (kind) {
+            case SubscriptionKind::Pattern:
+                return add ? "PSUBSCRIBE" : "PUNSUBSCRIBE";
+            case SubscriptionKind::Shard:
+                return add ? "SSUBSCRIBE" : "SUNSUBSCRIBE";
+            default:
+                return add ? "SUBSCRIBE" : "UNSUBSCRIBE";
+        }
+    }
+
+    // GET the way getButtonState has always read it: only a string is a value, nil, an
+    // error reply such as WRONGTYPE or anything else leaves it empty and the key reset
+    class ButtonStateSink : public RedisDecodeSink
+    {
+
+    public:
+
+        std::optional<std::string> value;
+
+        void string(int type, const char* str, size_t len) override
+        {
+            if (type == REDIS_REPLY_STRING) {
+                value.emplace(str, len);
+            }
+        }
+        void integer(long long) override {}
+        void number(double) override {}
+        void nil() override {}
+        void boolean(bool) override {}
+        RedisDecodeSink* array(int, size_t) override { return ignore(); }
+
+    };
+}
 
 RedisClient::RedisClient(std::string host, int port)
-    : serverHost(host), serverPort(port), publisher(nullptr), subscriber(nullptr)
+    : RedisClient(RedisEndpoint{host, port}, nullptr)
+{
+}
+
+RedisClient::RedisClient(RedisSentinelConfig config)
+    : RedisClient(RedisEndpoint(), std::make_unique<RedisSentinel>(std::move(config)))
+{
+}
+
+RedisClient::RedisClient(const RedisEndpoint& address, std::unique_ptr<RedisSentinel> failover)
+    : serverHost(failover ? failover->master().host : address.host),
+      serverPort(failover ? failover->master().port : address.port),
+      publisher(nullptr), subscriber(nullptr), sentinel(std::move(failover)),
+      latency(std::make_unique<RedisLatencyRecorder>())
 {
+    messageMetric = latency->metric("message");
+    reconnectMetric = latency->metric("reconnect");
+    createReconnectors();
     connect();
+
+    // Connections are moved by the threads that own them, a switch only has to wake
+    // the subscriber out of its poll, the others notice on their next command
+    if (sentinel) {
+        sentinel->start([this](const RedisEndpoint&) { wakeSubscriber(); });
+    }
 }
 
 RedisClient::~RedisClient()
 {
-    if (publisher) {
-        redisFree(publisher.get());
+    // The subscriber thread may still run, or may have given up on its own and only
+    // be waiting to be joined, either way it goes before what it reads from
+    stopSubscriber();
+
+    // No failover may reach the client while it is torn down
+    if (sentinel) {
+        sentinel->stop();
+    }
+
+    // Publishes already queued are sent before the publisher thread exits
+    stopPublisher();
+
+    // Async contexts must be freed from the loop thread before the loop goes away
+    if (loop) {
+        loop->invoke([this]() {
+            asyncSubscriber = nullptr;
+            asyncCommands = nullptr;
+            std::vector<redisAsyncContext*> contexts;
+            contexts.swap(asyncContexts);
+            for (redisAsyncContext* context : contexts) {
+                redisAsyncFree(context);
+            }
+        });
+        loop->stop();
     }
-    if (subscriber) {
-        redisFree(subscriber.get());
+
+    // The contexts are released through their redisFree deleters
+    publisher.reset();
+    subscriber.reset();
+
+    if (subscriberWakeFd >= 0) {
+        close(subscriberWakeFd);
     }
 }
 
 void RedisClient::setSubscriberChanels(std::vector<std::string> channels)
 {
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
     subscriberChannels = channels;
 }
 
 std::vector<std::string> RedisClient::getSubscriberChannels() const
 {
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
     return subscriberChannels;
 }
 
+void RedisClient::setSubscriberPatterns(std::vector<std::string> patterns)
+{
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    subscriberPatterns = patterns;
+}
+
+std::vector<std::string> RedisClient::getSubscriberPatterns() const
+{
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    return subscriberPatterns;
+}
+
+void RedisClient::setSubscriberShardChannels(std::vector<std::string> channels)
+{
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    subscriberShardChannels = channels;
+}
+
+std::vector<std::string> RedisClient::getSubscriberShardChannels() const
+{
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    return subscriberShardChannels;
+}
+
+void RedisClient::subscribe(const std::vector<std::string>& names, SubscriptionKind kind)
+{
+    changeSubscriptions(names, kind, true);
+}
+
+void RedisClient::unsubscribe(const std::vector<std::string>& names, SubscriptionKind kind)
+{
+    changeSubscriptions(names, kind, false);
+}
+
+std::vector<std::string>& RedisClient::subscriptionList(SubscriptionKind kind)
+{
+    switch (kind) {
+        case SubscriptionKind::Pattern:
+            return subscriberPatterns;
+        case SubscriptionKind::Shard:
+            return subscriberShardChannels;
+        default:
+            return subscriberChannels;
+    }
+}
+
+void RedisClient::changeSubscriptions(const std::vector<std::string>& names, SubscriptionKind kind, bool add)
+{
+    if (names.empty()) {
+        return;
+    }
+    if (kind == SubscriptionKind::Shard && subscriberMode == SubscriberMode::EventLoop) {
+        throw std::runtime_error("Sharded subscriptions need the Thread subscriber mode");
+    }
+
+    // The lists are what a reconnect restores, the command only matters while running
+    std::vector<std::string> command{subscriptionCommand(kind, add)};
+    bool running = false;
+    {
+        std::lock_guard<std::mutex> lock(subscriptionMutex);
+        std::vector<std::string>& list = subscriptionList(kind);
+        for (const auto& name : names) {
+            auto found = std::find(list.begin(), list.end(), name);
+            if (add && found == list.end()) {
+                list.push_back(name);
+            } else if (!add && found != list.end()) {
+                list.erase(found);
+            }
+            command.push_back(name);
+        }
+
+        running = subscriberRunning.load();
+        if (running && subscriberMode == SubscriberMode::Thread) {
+            subscriptionChanges.push_back(command);
+        }
+    }
+    if (!running) {
+        return;
+    }
+
+    // The subscriber context belongs to its reader, the change is sent from there
+    if (subscriberMode == SubscriberMode::Thread) {
+        wakeSubscriber();
+        return;
+    }
+    eventLoop().post([this, command]() {
+        if (asyncSubscriber == nullptr) {
+            return;
+        }
+        std::vector<const char*> argv;
+        std::vector<size_t> argvlen;
+        for (const auto& arg : command) {
+            argv.push_back(arg.c_str());
+            argvlen.push_back(arg.size());
+        }
+        redisAsyncCommandArgv(asyncSubscriber, &RedisClient::onAsyncMessage, this,
+                              static_cast<int>(argv.size()), argv.data(), argvlen.data());
+    });
+}
+
+void RedisClient::wakeSubscriber()
+{
+    if (subscriberWakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(subscriberWakeFd, &one, sizeof(one));
+        (void)written; // A full counter already guarantees a wake up
+    }
+}
+
+void RedisClient::setSubscriberMode(SubscriberMode mode)
+{
+    if (subscriberRunning.load()) {
+        throw std::runtime_error("Cannot change subscriber mode while running");
+    }
+    subscriberMode = mode;
+}
+
+void RedisClient::usePooledAllocator(RedisAllocatorConfig config)
+{
+    RedisAllocator::install(config);
+}
+
+RedisAllocatorMetrics RedisClient::getAllocatorMetrics()
+{
+    return RedisAllocator::metrics();
+}
+
+size_t RedisClient::trimAllocator()
+{
+    return RedisAllocator::trim();
+}
+
+RedisEventLoop& RedisClient::eventLoop()
+{
+    std::call_once(loopOnce, [this]() {
+        loop = std::make_unique<RedisEventLoop>();
+        loop->start();
+    });
+    return *loop;
+}
+
+redisAsyncContext* RedisClient::connectAsync()
+{
+    RedisEventLoop& events = eventLoop();
+
+    RedisEndpoint address = serverAddress();
+    redisAsyncContext* context = redisAsyncConnect(address.host.c_str(), address.port);
+    if (context == nullptr || context->err) {
+        if (context) {
+            redisAsyncFree(context);
+        }
+        throw std::runtime_error("Could not connect async context");
+    }
+    redisSetOutputBufferRetention(&context->c, REDIS_OBUF_MAX_RETAIN);
+
+    // The context is owned by the client and only touched on the loop thread from here on
+    events.invoke([this, &events, context]() {
+        redisAsyncSetDisconnectCallback(context, &RedisClient::onAsyncDisconnect);
+        context->data = this;
+        events.attach(context);
+        asyncContexts.push_back(context);
+    });
+    return context;
+}
+
+void RedisClient::sendAsync(int argc, const char** argv, const size_t* argvlen, RedisAsyncCompletion* completion)
+{
+    RedisEventLoop& events = eventLoop();
+    if (!events.inLoopThread()) {
+        events.post([this, argc, argv, argvlen, completion]() { sendAsync(argc, argv, argvlen, completion); });
+        return;
+    }
+
+    // Connected on first use, and again after the connection was lost
+    if (asyncCommands == nullptr) {
+        try {
+            asyncCommands = connectAsync();
+        } catch (const std::exception& e) {
+            spdlog::error("Async command connection failed: {}", e.what());
+            completion->complete(completion, nullptr);
+            return;
+        }
+    }
+    if (redisAsyncCommandArgv(asyncCommands, &RedisClient::onAsyncReply, completion, argc, argv, argvlen) != REDIS_OK) {
+        completion->complete(completion, nullptr);
+    }
+}
+
+void RedisClient::onAsyncReply(redisAsyncContext* context, void* reply, void* privdata)
+{
+    (void)context;
+
+    // The reply is freed by hiredis once the completion returns
+    RedisAsyncCompletion* completion = static_cast<RedisAsyncCompletion*>(privdata);
+    completion->complete(completion, static_cast<redisReply*>(reply));
+}
+
+void RedisClient::onAsyncDisconnect(const redisAsyncContext* context, int status)
+{
+    // hiredis frees the context after this callback, forget it so it is not freed twice
+    RedisClient* client = static_cast<RedisClient*>(context->data);
+    if (client == nullptr) {
+        return;
+    }
+
+    auto& contexts = client->asyncContexts;
+    for (size_t i = 0; i < contexts.size(); ++i) {
+        if (contexts[i] == context) {
+            contexts.erase(contexts.begin() + i);
+            break;
+        }
+    }
+    if (client->asyncCommands == context) {
+        client->asyncCommands = nullptr; // The next sendAsync connects again
+    }
+    if (client->asyncSubscriber == context) {
+        client->asyncSubscriber = nullptr;
+        if (status != REDIS_OK) {
+            client->subscriberRunning.store(false);
+        }
+    }
+}
+
 void RedisClient::connect()
 {
+    RedisEndpoint address = serverAddress();
+
     // Create a new Redis context for the publisher
-    publisher.reset(redisConnect(serverHost.c_str(), serverPort));
+    publisher.reset(redisConnect(address.host.c_str(), address.port), redisFree);
     if (publisher == nullptr || publisher->err) {
         throw std::runtime_error("Could not connect to Redis publisher");
     }
 
+    // Commands are written from a buffer kept across writes rather than one allocated per write
+    redisSetOutputBufferRetention(publisher.get(), REDIS_OBUF_MAX_RETAIN);
+
     // Create a new Redis context for the subscriber
-    subscriber.reset(redisConnect(serverHost.c_str(), serverPort));
+    subscriber.reset(redisConnect(address.host.c_str(), address.port), redisFree);
     if (subscriber == nullptr || subscriber->err) {
         throw std::runtime_error("Could not connect to Redis subscriber");
     }
+
+    publisherArena = std::make_unique<RedisReplyArena>();
+    subscriberArena = std::make_unique<RedisReplyArena>();
+
+    // An unreachable replica is retried on later reads, which go to the master meanwhile
+    if (sentinel && sentinel->readFromReplicas()) {
+        RedisEndpoint readAddress = sentinel->replica();
+        replica.reset(redisConnect(readAddress.host.c_str(), readAddress.port), redisFree);
+        if (replica == nullptr) {
+            throw std::runtime_error("Could not connect to Redis replica");
+        }
+    }
+}
+
+RedisEndpoint RedisClient::serverAddress() const
+{
+    // New connections go to the master Sentinel reports right now
+    return sentinel ? sentinel->master() : RedisEndpoint{serverHost, serverPort};
+}
+
+bool RedisClient::masterMoved(std::atomic<uint64_t>& seen) const
+{
+    if (!sentinel) {
+        return false;
+    }
+    uint64_t generation = sentinel->generation();
+    if (seen.load(std::memory_order_relaxed) == generation) {
+        return false;
+    }
+    return seen.exchange(generation, std::memory_order_relaxed) != generation;
+}
+
+redisContext* RedisClient::replicaContext(std::unique_lock<std::mutex>& hold) const
+{
+    if (!replica) {
+        return nullptr;
+    }
+
+    // The replica stays locked for as long as hold is kept, a replica that cannot be
+    // reached right now leaves the read to the master
+    hold = std::unique_lock<std::mutex>(replicaMutex);
+    if (replica->err && !replicaReconnect->tryReconnect(replica.get())) {
+        hold.unlock();
+        return nullptr;
+    }
+    return replica.get();
 }
 
 void RedisClient::startSubscriber()
@@ -52,112 +456,1101 @@ void RedisClient::startSubscriber()
     if (subscriberRunning.load()) {
         return; // Already running
     }
+    if (subscriberMode == SubscriberMode::EventLoop && !getSubscriberShardChannels().empty()) {
+        throw std::runtime_error("Sharded subscriptions need the Thread subscriber mode");
+    }
+
+    // A thread that gave up reconnecting has exited on its own but not been joined
+    if (subscriberThread.joinable()) {
+        subscriberThread.join();
+    }
     subscriberRunning.store(true);
-    // Start the subscriber loop in a separate thread
+    if (dispatchConfig.workers > 0) {
+        dispatcher = std::make_unique<RedisMessageDispatcher>(dispatchConfig,
+            [this](const redisReply* reply, std::chrono::steady_clock::time_point received) {
+                handleMessage(reply);
+                recordMessage(received);
+            });
+    }
+    if (subscriberMode == SubscriberMode::EventLoop) {
+        startAsyncSubscriber();
+        return;
+    }
+    // Start the subscriber loop in a separate thread, woken through an eventfd for
+    // subscription changes and stop
+    if (subscriberWakeFd < 0) {
+        subscriberWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (subscriberWakeFd < 0) {
+            subscriberRunning.store(false);
+            dispatcher.reset();
+            throw std::runtime_error("Could not create subscriber wake up descriptor");
+        }
+    }
     subscriberThread = std::thread(&RedisClient::subscriberLoop, this);
 }
 
 void RedisClient::stopSubscriber()
 {
-    if (!subscriberRunning.load()) {
-        return; // Not running
+    bool wasRunning = subscriberRunning.exchange(false);
+    wakeSubscriber();
+    if (subscriberMode == SubscriberMode::EventLoop && wasRunning) {
+        stopAsyncSubscriber();
     }
-    subscriberRunning.store(false);
+    // A thread that gave up reconnecting has already left its loop, it is still joined
     if (subscriberThread.joinable()) {
         subscriberThread.join();
     }
+
+    // Messages already queued are still delivered before the workers exit
+    dispatcher.reset();
 }
 
-void RedisClient::subscriberLoop()
+void RedisClient::setSubscriberDispatch(RedisDispatchConfig config)
 {
-    redisReply* reply = nullptr;
-    for(auto& channel : subscriberChannels)
-    {
-        reply = static_cast<redisReply*>(redisCommand(subscriber.get(), "SUBSCRIBE %s",channel.c_str()));
-        freeReplyObject(reply);
+    if (subscriberRunning.load()) {
+        throw std::runtime_error("Cannot change subscriber dispatch while running");
     }
+    dispatchConfig = config;
+}
 
-    while (subscriberRunning)
-    {
-        if (redisGetReply(subscriber.get(), (void**)&reply) == REDIS_OK)
-        {
-            if (reply && reply->type == REDIS_REPLY_ARRAY && reply->elements == 3) {
-                // Process the message
-                messageHandler(splitString(reply->element[2]->str));
-            } else {
-                freeReplyObject(reply);
-            }
-        } else
-        {
-            throw std::runtime_error("Failed to receive reply from Redis");
-            break;
-        }
-    }
+RedisDispatchMetrics RedisClient::getDispatchMetrics() const
+{
+    return dispatcher ? dispatcher->metrics() : RedisDispatchMetrics();
 }
 
-void RedisClient::publish(const std::string& channel, const std::string& message)
+bool RedisClient::isMessage(const redisReply* reply)
 {
-    if (!publisher) {
-        throw std::runtime_error("Publisher not initialized");
+    if (reply == nullptr || reply->type != REDIS_REPLY_ARRAY || reply->elements < 3 ||
+        reply->element[0]->str == nullptr) {
+        return false;
+    }
+
+    // message and smessage carry channel and payload, pmessage the pattern first
+    const char* type = reply->element[0]->str;
+    if (reply->elements == 3) {
+        return strcmp(type, "message") == 0 || strcmp(type, "smessage") == 0;
     }
-    redisCommand(publisher.get(), "PUBLISH %s %s", channel.c_str(), message.c_str());
+    return reply->elements == 4 && strcmp(type, "pmessage") == 0;
 }
 
-void RedisClient::setAndPublish(const std::string& channel, const std::string& message)
+void RedisClient::deliverMessage(redisReply* reply)
 {
-    if (!publisher) {
-        throw std::runtime_error("Publisher not initialized");
+    // Takes ownership of the reply, anything other than a message is dropped here
+    if (!isMessage(reply)) {
+        freeReplyObject(reply);
+        return;
     }
 
-    std::string joint = channel + ":" + message;
-    redisReply* reply = static_cast<redisReply*>(redisCommand(publisher.get(), "PUBLISH %s %s", channel.c_str(), joint.c_str()));
+    auto received = std::chrono::steady_clock::now();
+    if (dispatcher) {
+        dispatcher->dispatch(RedisReplyPtr(reply), received);
+        return;
+    }
+    handleMessage(reply);
+    recordMessage(received);
     freeReplyObject(reply);
+}
 
-    // Restructing the channel and message
-    // CHANNEL | SECTION:SECTION:VALUE
-    // CHANNEL:SECTION:SECTION | VALUE
-    std::vector<std::string> channel_sections = splitString(message.c_str());
-    std::string value = channel_sections.back();
-    channel_sections.pop_back();
-    channel_sections.insert(channel_sections.begin(), channel);
+void RedisClient::recordCommand(std::string_view command, std::chrono::steady_clock::time_point start) const
+{
+    if (!latencyTracking.load(std::memory_order_relaxed) || command.empty()) {
+        return;
+    }
 
+    // Metrics are keyed by the upper case name, copied without allocating
+    char name[32];
+    size_t length = std::min(command.size(), sizeof(name));
+    for (size_t i = 0; i < length; ++i) {
+        name[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(command[i])));
+    }
+    latency->record(latency->metric(std::string_view(name, length)), start);
+}
 
-    reply = static_cast<redisReply*>(redisCommand(publisher.get(), "SET %s %s", joinStrings(channel_sections, ":").c_str(), value.c_str()));
-    freeReplyObject(reply);
+void RedisClient::recordMessage(std::chrono::steady_clock::time_point received) const
+{
+    if (latencyTracking.load(std::memory_order_relaxed)) {
+        latency->record(messageMetric, received);
+    }
 }
 
-void RedisClient::setSubscriberCallback(std::function<void(std::vector<std::string>)> callback)
+void RedisClient::setLatencyTracking(bool enabled)
 {
-    messageHandler = callback;
+    latencyTracking.store(enabled);
 }
 
-redisReply* RedisClient::executeCommand(std::string command) const
+std::map<std::string, RedisLatencySnapshot> RedisClient::getLatencySnapshot() const
 {
-    if (!publisher) {
-        throw std::runtime_error("Context not initialized");
-    }
-    redisReply* reply = static_cast<redisReply*>(redisCommand(publisher.get(), command.c_str()));
-    if (reply == nullptr) {
-        throw std::runtime_error("Failed to execute command");
+    return latency->snapshot();
+}
+
+void RedisClient::startLatencyDump(std::chrono::milliseconds interval)
+{
+    latency->startDump(interval);
+}
+
+void RedisClient::stopLatencyDump()
+{
+    latency->stopDump();
+}
+
+void RedisClient::handleMessage(const redisReply* reply)
+{
+    // The view callback reads straight out of the reply, which the caller frees
+    // only after we return
+    size_t channel = reply->elements == 4 ? 2 : 1;
+    const redisReply* payload = reply->element[channel + 1];
+    if (messageViewHandler) {
+        RedisMessageView view;
+        view.channel = std::string_view(reply->element[channel]->str, reply->element[channel]->len);
+        view.payload = std::string_view(payload->str, payload->len);
+        if (reply->elements == 4) {
+            view.pattern = std::string_view(reply->element[1]->str, reply->element[1]->len);
+        }
+        messageViewHandler(view);
+    } else if (messageHandler) {
+        messageHandler(splitString(payload->str));
     }
+}
 
-    // Return the response
-    return reply;
+void RedisClient::startAsyncSubscriber()
+{
+    redisAsyncContext* context = connectAsync();
+
+    eventLoop().invoke([this, context]() {
+        asyncSubscriber = context;
+        context->c.flags |= REDIS_NO_AUTO_FREE_REPLIES;
+
+        // One multi-argument command per kind, hiredis registers the callback for each name
+        std::lock_guard<std::mutex> lock(subscriptionMutex);
+        for (SubscriptionKind kind : {SubscriptionKind::Channel, SubscriptionKind::Pattern}) {
+            const std::vector<std::string>& names = subscriptionList(kind);
+            if (names.empty()) {
+                continue;
+            }
+            std::vector<const char*> argv{subscriptionCommand(kind, true)};
+            std::vector<size_t> argvlen{strlen(argv[0])};
+            for (const auto& name : names) {
+                argv.push_back(name.c_str());
+                argvlen.push_back(name.size());
+            }
+            redisAsyncCommandArgv(context, &RedisClient::onAsyncMessage, this,
+                                  static_cast<int>(argv.size()), argv.data(), argvlen.data());
+        }
+    });
 }
 
-bool RedisClient::getButtonState(std::string key) const
+void RedisClient::stopAsyncSubscriber()
 {
-    bool state = false;
-    std::string message = "GET ";
-    message += key;
+    eventLoop().invoke([this]() {
+        if (asyncSubscriber == nullptr) {
+            return;
+        }
+        redisAsyncContext* context = asyncSubscriber;
+        asyncSubscriber = nullptr;
+        for (size_t i = 0; i < asyncContexts.size(); ++i) {
+            if (asyncContexts[i] == context) {
+                asyncContexts.erase(asyncContexts.begin() + i);
+                break;
+            }
+        }
+        redisAsyncFree(context);
+    });
+}
+
+void RedisClient::onAsyncMessage(redisAsyncContext* context, void* reply, void* privdata)
+{
+    (void)context;
+    RedisClient* client = static_cast<RedisClient*>(privdata);
+
+    // The subscriber context does not auto free replies, ownership passes to us here
+    client->deliverMessage(static_cast<redisReply*>(reply));
+}
+
+void RedisClient::subscriberLoop()
+{
+    // Nothing may escape this thread, a lost connection is reconnected with backoff
+    // and every channel subscribed again
+    while (subscriberRunning)
+    {
+        bool moved = masterMoved(subscriberGeneration);
+        if ((subscriber->err || moved) && !reconnect(*subscriberReconnect, subscriber.get(), subscriberRunning)) {
+            if (subscriberRunning.exchange(false)) {
+                spdlog::error("Subscriber gave up reconnecting to {}:{}", subscriber->tcp.host, subscriber->tcp.port);
+            }
+            break;
+        }
+        subscribeChannels();
+        if (!subscriber->err) {
+            readMessages();
+        }
+    }
+}
+
+void RedisClient::subscribeChannels()
+{
+    // Every kind goes out as one multi-argument command and all of them in one write,
+    // the confirmations are read and dropped by readMessages
+    std::vector<std::vector<std::string>> commands;
+    {
+        std::lock_guard<std::mutex> lock(subscriptionMutex);
+        subscriptionChanges.clear();
+        for (SubscriptionKind kind : {SubscriptionKind::Channel, SubscriptionKind::Pattern, SubscriptionKind::Shard}) {
+            const std::vector<std::string>& names = subscriptionList(kind);
+            if (!names.empty()) {
+                commands.emplace_back(1, subscriptionCommand(kind, true));
+                commands.back().insert(commands.back().end(), names.begin(), names.end());
+            }
+        }
+    }
+    sendSubscriberCommands(commands);
+}
 
-    redisReply* response = executeCommand(message.c_str());
+bool RedisClient::sendSubscriberCommands(const std::vector<std::vector<std::string>>& commands)
+{
+    redisContext* context = subscriber.get();
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    for (const auto& command : commands) {
+        argv.clear();
+        argvlen.clear();
+        for (const auto& arg : command) {
+            argv.push_back(arg.data());
+            argvlen.push_back(arg.size());
+        }
+        if (redisAppendCommandArgv(context, static_cast<int>(argv.size()), argv.data(), argvlen.data()) != REDIS_OK) {
+            return false;
+        }
+    }
+
+    int done = 0;
+    while (!done) {
+        if (redisBufferWrite(context, &done) != REDIS_OK) {
+            return false; // The connection failed, the loop reconnects
+        }
+    }
+    return true;
+}
+
+void RedisClient::readMessages()
+{
+    // Delivered inline every message is consumed before the next read, so replies are
+    // built in the arena and reclaimed with one reset instead of a free per node.
+    // The binding is dropped on return, before a reconnect replaces the reader
+    std::unique_ptr<RedisReplyArena::Binding> binding;
+    if (!dispatcher) {
+        binding = std::make_unique<RedisReplyArena::Binding>(subscriber.get(), *subscriberArena);
+    }
+
+    redisContext* context = subscriber.get();
+    pollfd watched[2] = {{context->fd, POLLIN, 0}, {subscriberWakeFd, POLLIN, 0}};
+    redisReply* reply = nullptr;
+    while (subscriberRunning && !context->err)
+    {
+        // Replies already buffered are handed out before waiting on the socket again
+        if (redisGetReplyFromReader(context, (void**)&reply) != REDIS_OK) {
+            break;
+        }
+        if (reply != nullptr)
+        {
+            if (reply->type == REDIS_REPLY_ERROR) {
+                spdlog::warn("Subscriber command failed: {}", reply->str);
+            }
+
+            // Process the message, inline or on the dispatcher workers
+            if (binding) {
+                if (isMessage(reply)) {
+                    auto received = std::chrono::steady_clock::now();
+                    handleMessage(reply);
+                    recordMessage(received);
+                }
+                subscriberArena->reset();
+            } else {
+                deliverMessage(reply);
+            }
+            continue;
+        }
+
+        watched[0].fd = context->fd;
+        if (poll(watched, 2, -1) < 0) {
+            continue; // Interrupted by a signal
+        }
+        if (watched[1].revents & POLLIN) {
+            uint64_t wakes = 0;
+            ssize_t drained = read(subscriberWakeFd, &wakes, sizeof(wakes));
+            (void)drained;
+
+            std::vector<std::vector<std::string>> changes;
+            {
+                std::lock_guard<std::mutex> lock(subscriptionMutex);
+                changes.swap(subscriptionChanges);
+            }
+            if (!changes.empty() && !sendSubscriberCommands(changes)) {
+                break;
+            }
+
+            // Sentinel switched master, subscriberLoop moves the connection over
+            if (sentinel && sentinel->generation() != subscriberGeneration.load()) {
+                break;
+            }
+        }
+        if ((watched[0].revents & (POLLIN | POLLHUP | POLLERR)) && redisBufferRead(context) != REDIS_OK) {
+            break;
+        }
+    }
+
+    if (subscriberRunning && context->err) {
+        spdlog::warn("Subscriber connection lost: {}", context->errstr);
+    }
+}
+
+bool RedisClient::reconnect(RedisReconnector& reconnector, redisContext* context, const std::atomic<bool>& running)
+{
+    if (!reconnector.reconnect(context, [&running]() { return running.load(); })) {
+        return false;
+    }
+    if (latencyTracking.load(std::memory_order_relaxed)) {
+        latency->record(reconnectMetric, reconnector.lastRecoveryNanos());
+    }
+    spdlog::info("Reconnected to {}:{} after {:.1f}ms", context->tcp.host, context->tcp.port,
+                 reconnector.lastRecoveryNanos() / 1e6);
+    return true;
+}
+
+void RedisClient::setReconnectPolicy(RedisReconnectConfig config)
+{
+    if (subscriberRunning.load() || publisherThread.joinable()) {
+        throw std::runtime_error("Cannot change the reconnect policy while the subscriber or publisher runs");
+    }
+    reconnectConfig = config;
+    createReconnectors();
+}
+
+void RedisClient::createReconnectors()
+{
+    publisherReconnect = std::make_unique<RedisReconnector>(reconnectConfig);
+    subscriberReconnect = std::make_unique<RedisReconnector>(reconnectConfig);
+    queueReconnect = std::make_unique<RedisReconnector>(reconnectConfig);
+    replicaReconnect = std::make_unique<RedisReconnector>(reconnectConfig);
+
+    // With Sentinel every reconnect goes wherever the master or read replica is now
+    if (sentinel) {
+        auto master = [this]() { return sentinel->master(); };
+        publisherReconnect->follow(master);
+        subscriberReconnect->follow(master);
+        queueReconnect->follow(master);
+        replicaReconnect->follow([this]() { return sentinel->replica(); });
+    }
+}
+
+RedisReconnectMetrics RedisClient::getReconnectMetrics() const
+{
+    RedisReconnectMetrics metrics = publisherReconnect->metrics();
+    metrics.merge(subscriberReconnect->metrics());
+    metrics.merge(queueReconnect->metrics());
+    metrics.merge(replicaReconnect->metrics());
+    if (autoPipelining) {
+        metrics.merge(autoPipelining->reconnectMetrics());
+    }
+    return metrics;
+}
+
+void RedisClient::publish(const std::string& channel, const std::string& message)
+{
+    publish(channel, message, nullptr);
+}
+
+void RedisClient::publish(const std::string& channel, const std::string& message, PublishCallback done)
+{
+    if (!publisher) {
+        throw std::runtime_error("Publisher not initialized");
+    }
+    std::call_once(publisherOnce, [this]() { startPublisher(); });
+
+    PendingPublish pending{channel, message, std::move(done), std::chrono::steady_clock::now()};
+    if (!publishQueue->tryPush(std::move(pending))) {
+        // Never wait for room, the caller hears about it straight away instead
+        publishRejected.fetch_add(1, std::memory_order_relaxed);
+        PublishCallback fallback;
+        {
+            std::lock_guard<std::mutex> lock(publisherMutex);
+            fallback = publishCallback;
+        }
+        completePublish(pending, RedisPublishResult{false, 0, "Publish queue is full"}, fallback);
+        return;
+    }
+    publishQueued.fetch_add(1, std::memory_order_relaxed);
+
+    // Pairs with the fence in publisherLoop, either the publisher sees the new entry or
+    // we see it going to sleep and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (publisherSleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(publisherMutex);
+        publisherWake.notify_one();
+    }
+}
+
+void RedisClient::setPublishCallback(PublishCallback callback)
+{
+    // Used for publishes queued without a callback of their own
+    std::lock_guard<std::mutex> lock(publisherMutex);
+    publishCallback = callback;
+}
+
+void RedisClient::setPublishQueue(RedisPublishConfig config)
+{
+    if (publishQueue) {
+        throw std::runtime_error("Cannot change the publish queue once publishing has started");
+    }
+    publishConfig = config;
+}
+
+bool RedisClient::flushPublishes(std::chrono::milliseconds timeout)
+{
+    // True once everything queued so far has been answered and its callback has run
+    std::unique_lock<std::mutex> lock(publisherMutex);
+    return publishFlushed.wait_for(lock, timeout, [this]() {
+        return publishCompleted.load() >= publishQueued.load();
+    });
+}
+
+RedisPublishMetrics RedisClient::getPublishMetrics() const
+{
+    RedisPublishMetrics metrics;
+    metrics.queued = publishQueued.load(std::memory_order_relaxed);
+    metrics.failed = publishFailed.load(std::memory_order_relaxed);
+    metrics.published = publishCompleted.load(std::memory_order_relaxed) - metrics.failed;
+    metrics.rejected = publishRejected.load(std::memory_order_relaxed);
+    metrics.batches = publishBatches.load(std::memory_order_relaxed);
+    metrics.queueDepth = publishQueue ? publishQueue->size() : 0;
+    return metrics;
+}
+
+void RedisClient::startPublisher()
+{
+    // A connection of its own, the publisher context stays with the calling threads
+    RedisEndpoint address = serverAddress();
+    publishContext.reset(redisConnect(address.host.c_str(), address.port), redisFree);
+    if (publishContext == nullptr || publishContext->err) {
+        publishContext.reset();
+        throw std::runtime_error("Could not connect to Redis publish queue");
+    }
+    redisSetOutputBufferRetention(publishContext.get(), REDIS_OBUF_MAX_RETAIN);
+
+    publishQueue = std::make_unique<RedisBoundedQueue<PendingPublish>>(publishConfig.queueCapacity);
+    publishMetric = latency->metric("PUBLISH");
+    publisherRunning.store(true);
+    publisherThread = std::thread(&RedisClient::publisherLoop, this);
+}
+
+void RedisClient::stopPublisher()
+{
+    if (!publisherThread.joinable()) {
+        return; // Never started
+    }
+    publisherRunning.store(false);
+    {
+        std::lock_guard<std::mutex> lock(publisherMutex);
+        publisherWake.notify_one();
+    }
+    publisherThread.join();
+}
+
+void RedisClient::publisherLoop()
+{
+    const size_t maxBatch = std::max<size_t>(publishConfig.maxBatch, 1);
+    std::vector<PendingPublish> batch;
+    batch.reserve(maxBatch);
+    PendingPublish pending;
+
+    for (;;) {
+        while (batch.size() < maxBatch && publishQueue->tryPop(pending)) {
+            batch.push_back(std::move(pending));
+        }
+        if (!batch.empty()) {
+            sendPublishBatch(batch);
+            batch.clear();
+
+            // Taking the lock orders the counters before a flushing thread's check
+            {
+                std::lock_guard<std::mutex> lock(publisherMutex);
+            }
+            publishFlushed.notify_all();
+            continue;
+        }
+
+        // Queued publishes are still sent after stopPublisher()
+        if (!publisherRunning.load()) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(publisherMutex);
+        publisherSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (publishQueue->empty() && publisherRunning.load()) {
+            publisherWake.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        publisherSleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void RedisClient::sendPublishBatch(std::vector<PendingPublish>& batch)
+{
+    redisContext* context = publishContext.get();
+    PublishCallback fallback;
+    {
+        std::lock_guard<std::mutex> lock(publisherMutex);
+        fallback = publishCallback;
+    }
+
+    bool tracking = latencyTracking.load(std::memory_order_relaxed);
+    size_t answered = 0;
+    size_t replaying = 0;
+    bool moved = masterMoved(queueGeneration);
+    while (answered < batch.size()) {
+        // A lost connection is retried with backoff until it is back or the client stops,
+        // meanwhile new publishes fill the queue and are rejected once it is full
+        if ((context->err || moved) && !reconnect(*queueReconnect, context, publisherRunning)) {
+            break;
+        }
+        moved = false;
+        queueReconnect->countReplayed(replaying);
+
+        size_t appended = answered;
+        for (; appended < batch.size(); ++appended) {
+            const PendingPublish& pending = batch[appended];
+            const char* argv[] = {"PUBLISH", pending.channel.data(), pending.message.data()};
+            const size_t argvlen[] = {7, pending.channel.size(), pending.message.size()};
+            if (redisAppendCommandArgv(context, 3, argv, argvlen) != REDIS_OK) {
+                break;
+            }
+        }
+        publishBatches.fetch_add(1, std::memory_order_relaxed);
+
+        // The first read writes the whole batch out before any reply is waited on
+        for (; answered < appended; ++answered) {
+            redisReply* reply = nullptr;
+            if (redisGetReply(context, reinterpret_cast<void**>(&reply)) != REDIS_OK || reply == nullptr) {
+                break;
+            }
+
+            RedisPublishResult result;
+            if (reply->type == REDIS_REPLY_INTEGER) {
+                result.ok = true;
+                result.receivers = reply->integer;
+            } else {
+                result.error = reply->str ? std::string(reply->str, reply->len) : "Unexpected reply to PUBLISH";
+            }
+            freeReplyObject(reply);
+
+            // Latency covers the time spent queued as well as the round trip
+            if (!result.ok) {
+                publishFailed.fetch_add(1, std::memory_order_relaxed);
+            } else if (tracking) {
+                latency->record(publishMetric, batch[answered].queued);
+            }
+            completePublish(batch[answered], result, fallback);
+            publishCompleted.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Publishes sent on a connection that then failed may or may not have reached
+        // Redis, they are only sent again when replay is on
+        if (!context->err || !reconnectConfig.replay) {
+            break;
+        }
+        replaying = batch.size() - answered;
+    }
+
+    RedisPublishResult failure;
+    failure.error = context->err ? context->errstr : "Failed to queue publish";
+    for (; answered < batch.size(); ++answered) {
+        publishFailed.fetch_add(1, std::memory_order_relaxed);
+        completePublish(batch[answered], failure, fallback);
+        publishCompleted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RedisClient::completePublish(PendingPublish& pending, const RedisPublishResult& result,
+                                  const PublishCallback& fallback)
+{
+    const PublishCallback& done = pending.done ? pending.done : fallback;
+    if (!done) {
+        if (!result.ok) {
+            spdlog::error("Publish to {} failed: {}", pending.channel, result.error);
+        }
+        return;
+    }
+
+    // A throwing callback must not take the publisher thread down with it
+    try {
+        done(pending.channel, result);
+    } catch (const std::exception& e) {
+        spdlog::error("Publish callback failed: {}", e.what());
+    }
+}
+
+void RedisClient::setAndPublish(const std::string& channel, const std::string& message, PublishMode mode)
+{
+    if (!publisher) {
+        throw std::runtime_error("Publisher not initialized");
+    }
+
+    std::string joint = channel + ":" + message;
+
+    // Restructing the channel and message
+    // CHANNEL | SECTION:SECTION:VALUE
+    // CHANNEL:SECTION:SECTION | VALUE
+    // Sections split the way std::getline splits them, a trailing ':' ends the last
+    // section rather than starting an empty value
+    std::string_view sections(message);
+    if (!sections.empty() && sections.back() == ':') {
+        sections.remove_suffix(1);
+    }
+    std::string key = channel;
+    std::string value(sections);
+    size_t split = sections.rfind(':');
+    if (split != std::string_view::npos) {
+        key = joint.substr(0, channel.size() + 1 + split);
+        value = std::string(sections.substr(split + 1));
+    }
+
+    if (mode == PublishMode::Sequential) {
+        freeReplyObject(command(RedisCommands::PUBLISH, channel, joint));
+        freeReplyObject(command(RedisCommands::SET, key, value));
+        return;
+    }
+
+    // The auto pipeline's connection is shared by every thread, the commands are queued
+    // as one request so nothing another caller sends lands between MULTI and EXEC
+    if (autoPipelining && !cluster) {
+        std::string batch;
+        size_t commands = 2;
+        if (mode == PublishMode::Transaction) {
+            batch += RedisProtocol::formatCommand(RedisCommands::MULTI);
+        }
+        batch += RedisProtocol::formatCommand(RedisCommands::PUBLISH, channel, joint);
+        batch += RedisProtocol::formatCommand(RedisCommands::SET, key, value);
+        if (mode == PublishMode::Transaction) {
+            batch += RedisProtocol::formatCommand(RedisCommands::EXEC);
+            commands += 2;
+        }
+
+        RedisReplyPtr last(sendPipelined(batch, commands));
+        if (mode == PublishMode::Transaction &&
+            (last->type == REDIS_REPLY_ERROR || last->type == REDIS_REPLY_NIL)) {
+            throw std::runtime_error("Failed to execute setAndPublish transaction");
+        }
+        return;
+    }
+
+    // In a cluster both commands go to the node owning the key, PUBLISH reaches every node
+    RedisConnectionPool::Lease lease;
+    Pipeline batch(commandContext(lease, key));
+    if (mode == PublishMode::Transaction) {
+        batch.append({"MULTI"});
+    }
+    batch.publish(channel, joint);
+    batch.set(key, value);
+    if (mode == PublishMode::Transaction) {
+        batch.append({"EXEC"});
+    }
+
+    std::vector<RedisResult> results = batch.execute();
+    if (mode == PublishMode::Transaction && (results.back().isError() || results.back().isNil())) {
+        throw std::runtime_error("Failed to execute setAndPublish transaction");
+    }
+}
+
+void RedisClient::setSubscriberCallback(std::function<void(std::vector<std::string>)> callback)
+{
+    messageHandler = callback;
+}
+
+void RedisClient::setSubscriberViewCallback(std::function<void(const RedisMessageView&)> callback)
+{
+    // Takes precedence over the vector callback when both are set
+    messageViewHandler = callback;
+}
+
+redisReply* RedisClient::executeCommand(std::string command) const
+{
+    // The command is parsed as a hiredis format string, prefer executeArgv or
+    // command() for values that may contain spaces, '%' or binary data
+    if (cluster || autoPipelining) {
+        char* target = nullptr;
+        int length = redisFormatCommand(&target, command.c_str());
+        if (length < 0) {
+            throw std::runtime_error("Failed to format command");
+        }
+        std::string formatted(target, static_cast<size_t>(length));
+        redisFreeCommand(target);
+        return sendFormatted(formatted);
+    }
+
+    RedisConnectionPool::Lease lease;
+    redisContext* context = commandContext(lease);
+    auto start = std::chrono::steady_clock::now();
+    redisReply* reply = static_cast<redisReply*>(redisCommand(context, command.c_str()));
+    if (reply == nullptr) {
+        throw std::runtime_error("Failed to execute command");
+    }
+    recordCommand(std::string_view(command).substr(0, command.find(' ')), start);
+
+    // Return the response
+    return reply;
+}
+
+template <typename Range>
+redisReply* RedisClient::sendRange(const Range& argv, redisContext* context) const
+{
+    std::vector<const char*> args;
+    std::vector<size_t> lengths;
+    args.reserve(argv.size());
+    lengths.reserve(argv.size());
+
+    for (const auto& arg : argv) {
+        args.push_back(arg.data());
+        lengths.push_back(arg.size());
+    }
+
+    return sendArgv(static_cast<int>(args.size()), args.data(), lengths.data(), context);
+}
+
+redisReply* RedisClient::executeArgv(std::initializer_list<std::string_view> argv) const
+{
+    return sendRange(argv);
+}
+
+redisReply* RedisClient::executeArgv(const std::vector<std::string>& argv) const
+{
+    return sendRange(argv);
+}
+
+size_t RedisClient::streamArgv(const std::vector<std::string>& argv, const RedisElementVisitor& visitor) const
+{
+    if (argv.empty()) {
+        throw std::runtime_error("Empty command");
+    }
+    RedisStreamSink sink(visitor);
+    decodeFormatted(RedisProtocol::formatArgv(argv), sink);
+    sink.rethrow();
+    return sink.elements();
+}
+
+redisReply* RedisClient::sendArgv(int argc, const char** argv, const size_t* argvlen,
+                                  redisContext* context) const
+{
+    if (argc == 0) {
+        throw std::runtime_error("Empty command");
+    }
+
+    // Without a context the command goes to the cluster, the pool or the publisher
+    auto start = std::chrono::steady_clock::now();
+    redisReply* reply = nullptr;
+    if (context == nullptr && cluster) {
+        std::string_view key = argc > 1 ? std::string_view(argv[1], argvlen[1]) : std::string_view();
+        reply = cluster->executeArgv(argc, argv, argvlen, key);
+    } else if (context == nullptr && autoPipelining) {
+        char* formatted = nullptr;
+        long long length = redisFormatCommandArgv(&formatted, argc, argv, argvlen);
+        if (length < 0) {
+            throw std::runtime_error("Failed to format command");
+        }
+        std::unique_ptr<char, void (*)(char*)> command(formatted, redisFreeCommand);
+        reply = sendPipelined(std::string_view(formatted, static_cast<size_t>(length)));
+    } else {
+        RedisConnectionPool::Lease lease;
+        if (context == nullptr) {
+            context = commandContext(lease);
+        }
+        reply = static_cast<redisReply*>(redisCommandArgv(context, argc, argv, argvlen));
+    }
+    if (reply == nullptr) {
+        throw std::runtime_error("Failed to execute command");
+    }
+    recordCommand(std::string_view(argv[0], argvlen[0]), start);
+    return reply;
+}
+
+void RedisClient::consumeArgv(std::initializer_list<std::string_view> argv,
+                              const std::function<void(const redisReply*)>& consumer) const
+{
+    consumeReply([this, argv](redisContext* context) { return sendRange(argv, context); }, consumer);
+}
+
+void RedisClient::consumeArgv(const std::vector<std::string>& argv,
+                              const std::function<void(const redisReply*)>& consumer) const
+{
+    consumeReply([this, &argv](redisContext* context) { return sendRange(argv, context); }, consumer);
+}
+
+void RedisClient::consumeReply(const std::function<redisReply*(redisContext*)>& send,
+                               const std::function<void(const redisReply*)>& consumer) const
+{
+    // Cluster replies may have followed a redirect to another node and auto pipelined
+    // replies are read on the I/O thread, both are heap built
+    if (cluster || autoPipelining) {
+        RedisReplyPtr reply(send(nullptr));
+        consumer(reply.get());
+        return;
+    }
+
+    RedisConnectionPool::Lease lease;
+    redisContext* context = commandContext(lease);
+    RedisReplyArena& arena = lease ? *lease.arena() : *publisherArena;
+
+    // The reply lives in the connection's arena and is reclaimed in one go once the
+    // consumer returns, it must not be kept or passed to freeReplyObject
+    struct ArenaReset
+    {
+        RedisReplyArena& arena;
+        ~ArenaReset() { arena.reset(); }
+    } reclaim{arena};
+
+    RedisReplyArena::Binding binding(context, arena);
+    consumer(send(context));
+}
+
+redisReply* RedisClient::sendFormatted(const std::string& formatted, redisContext* context) const
+{
+    auto start = std::chrono::steady_clock::now();
+    if (context == nullptr && cluster) {
+        redisReply* reply = cluster->executeFormatted(formatted, formattedArgument(formatted, 1));
+        recordCommand(formattedName(formatted), start);
+        return reply;
+    }
+    if (context == nullptr && autoPipelining) {
+        redisReply* reply = sendPipelined(formatted);
+        recordCommand(formattedName(formatted), start);
+        return reply;
+    }
+
+    RedisConnectionPool::Lease lease;
+    if (context == nullptr) {
+        context = commandContext(lease);
+    }
+
+    // The command is already RESP encoded, append it as-is and wait for the reply
+    redisReply* reply = nullptr;
+    if (redisAppendFormattedCommand(context, formatted.data(), formatted.size()) != REDIS_OK ||
+        redisGetReply(context, reinterpret_cast<void**>(&reply)) != REDIS_OK ||
+        reply == nullptr) {
+        throw std::runtime_error("Failed to execute command");
+    }
+    recordCommand(formattedName(formatted), start);
+    return reply;
+}
+
+void RedisClient::decodeFormatted(const std::string& formatted, RedisDecodeSink& sink, bool read) const
+{
+    // Cluster replies may have followed a redirect to another node and auto pipelined
+    // replies are read on the I/O thread, they are decoded from the heap reply instead
+    std::unique_lock<std::mutex> replicaHold;
+    redisContext* context = read ? replicaContext(replicaHold) : nullptr;
+    if (cluster || (autoPipelining && context == nullptr)) {
+        RedisReplyPtr reply(sendFormatted(formatted));
+        sink.decode(reply.get());
+        sink.check();
+        return;
+    }
+
+    RedisConnectionPool::Lease lease;
+    if (context == nullptr) {
+        context = commandContext(lease);
+    }
+
+    // The reader hands each value to the sink as it is parsed, all it returns is a marker
+    auto start = std::chrono::steady_clock::now();
+    {
+        RedisDecodeSink::Binding binding(context, sink);
+        void* decoded = nullptr;
+        if (redisAppendFormattedCommand(context, formatted.data(), formatted.size()) != REDIS_OK ||
+            redisGetReply(context, &decoded) != REDIS_OK ||
+            decoded == nullptr) {
+            throw std::runtime_error("Failed to execute command");
+        }
+    }
+    recordCommand(formattedName(formatted), start);
+    sink.check();
+}
+
+redisReply* RedisClient::sendPipelined(std::string_view formatted, size_t commands) const
+{
+    // After a Sentinel failover the I/O thread moves once its replies in flight are read
+    if (masterMoved(autoPipelineGeneration)) {
+        autoPipelining->moveTo(sentinel->master());
+    }
+    return autoPipelining->execute(formatted, commands);
+}
+
+void RedisClient::enableConnectionPool(RedisPoolConfig config)
+{
+    if (pool) {
+        return; // Already enabled
+    }
+    if (transport) {
+        throw std::runtime_error("The connection pool cannot be combined with the io_uring transport");
+    }
+    poolGeneration.store(sentinel ? sentinel->generation() : 0);
+    RedisEndpoint address = serverAddress();
+    pool = std::make_unique<RedisConnectionPool>(address.host, address.port, config);
+}
+
+RedisConnectionPool* RedisClient::connectionPool() const
+{
+    return pool.get();
+}
+
+void RedisClient::enableAutoPipelining(RedisAutoPipelineConfig config)
+{
+    if (autoPipelining) {
+        return; // Already enabled
+    }
+    if (transport) {
+        throw std::runtime_error("Auto pipelining cannot be combined with the io_uring transport");
+    }
+    autoPipelineGeneration.store(sentinel ? sentinel->generation() : 0);
+    autoPipelining = std::make_unique<RedisAutoPipeline>(serverAddress(), config, reconnectConfig);
+}
+
+RedisAutoPipeline* RedisClient::autoPipeline() const
+{
+    return autoPipelining.get();
+}
+
+void RedisClient::enableCluster(RedisClusterConfig config)
+{
+    if (cluster) {
+        return; // Already enabled
+    }
+    if (transport) {
+        throw std::runtime_error("Cluster routing cannot be combined with the io_uring transport");
+    }
+    cluster = std::make_unique<RedisCluster>(serverHost, serverPort, config);
+}
+
+RedisCluster* RedisClient::clusterClient() const
+{
+    return cluster.get();
+}
+
+RedisSentinel* RedisClient::sentinelClient() const
+{
+    return sentinel.get();
+}
+
+void RedisClient::enableClientCache(RedisCacheConfig config)
+{
+    if (cache) {
+        return; // Already enabled
+    }
+    RedisEndpoint address = serverAddress();
+    cache = std::make_unique<RedisClientCache>(address.host, address.port, config);
+}
+
+RedisClientCache* RedisClient::clientCache() const
+{
+    return cache.get();
+}
+
+std::optional<std::string> RedisClient::cachedGet(const std::string& key) const
+{
+    if (cache) {
+        return cache->get(key);
+    }
+
+    // Without the cache this is a plain GET decoded straight into the string, a
+    // replica serves it when Sentinel reads from replicas
+    std::optional<std::string> value;
+    RedisDecoder<std::optional<std::string>> decoder(value);
+    decodeFormatted(RedisProtocol::formatCommand(RedisCommands::GET, key), decoder, true);
+    return value;
+}
+
+redisContext* RedisClient::commandContext(RedisConnectionPool::Lease& lease, std::string_view key) const
+{
+    // Pooled connections are safe to use from any thread, the publisher is not
+    if (cluster) {
+        lease = cluster->acquire(key);
+        return lease.get();
+    }
+    if (pool) {
+        if (masterMoved(poolGeneration)) {
+            pool->moveTo(sentinel->master());
+        }
+        lease = pool->acquire();
+        return lease.get();
+    }
+    if (!publisher) {
+        throw std::runtime_error("Context not initialized");
+    }
+
+    // Calling threads never wait out a backoff, they fail fast until the retry is due.
+    // After a Sentinel failover the next command moves the connection to the new master
+    std::lock_guard<std::mutex> reconnecting(publisherReconnectMutex);
+    bool moved = masterMoved(publisherGeneration);
+    if ((publisher->err || moved) && !publisherReconnect->tryReconnect(publisher.get())) {
+        throw std::runtime_error("Redis connection lost, reconnect pending");
+    }
+    return publisher.get();
+}
+
+Pipeline RedisClient::pipeline()
+{
+    // A pipeline sends every command on one connection, cluster routing and auto
+    // pipelining choose the connection per command
+    if (cluster || autoPipelining) {
+        throw std::runtime_error("Pipelines are not available with cluster routing or auto pipelining");
+    }
+
+    // Reconnects and follows a failover like any other command, a pooled connection
+    // stays checked out until the pipeline is destroyed
+    RedisConnectionPool::Lease lease;
+    redisContext* context = commandContext(lease);
+    return Pipeline(context, std::move(lease));
+}
+
+bool RedisClient::enableUringTransport()
+{
+    if (!publisher) {
+        throw std::runtime_error("Context not initialized");
+    }
+    if (transport) {
+        return true; // Already enabled
+    }
+    if (pool || autoPipelining || cluster) {
+        throw std::runtime_error("The io_uring transport only serves the publisher connection, "
+                                 "it cannot be combined with the connection pool, auto pipelining or cluster routing");
+    }
+
+    // Falls back to the socket path when the kernel has no io_uring support
+    auto uring = std::make_unique<RedisUringTransport>(1);
+    if (!uring->install(publisher.get())) {
+        return false;
+    }
+    transport = std::move(uring);
+    return true;
+}
+
+bool RedisClient::getButtonState(std::string key) const
+{
+    bool state = false;
+
+    // Served from the client cache when enabled, otherwise a GET decoded into the string.
+    // A missing key is created below, so the read always goes to the master, a lagging
+    // replica could report a key that was just set as missing
+    std::optional<std::string> response;
+    if (cache) {
+        response = cache->get(key);
+    } else {
+        ButtonStateSink sink;
+        decodeFormatted(RedisProtocol::formatCommand(RedisCommands::GET, key), sink);
+        response = std::move(sink.value);
+    }
 
-    if (response->type == REDIS_REPLY_STRING)
+    if (response)
     {
-        if(strcmp(response->str, "ON") == 0)
+        if(*response == "ON")
         {
-            // strcmp returns 0 when the strings are equal
             state = true; // The button is ON
         }
         else
@@ -169,11 +1562,9 @@ bool RedisClient::getButtonState(std::string key) const
     {
         // The key does not exist or the response is not in the expected format
         // Creating the key and setting to the off state
-        message = "SET " + key + " OFF";
-        executeCommand(message.c_str());
+        freeReplyObject(command(RedisCommands::SET, key, "OFF"));
     }
 
-    freeReplyObject(response);
     return state;
 }
 
@@ -188,13 +1579,10 @@ bool RedisClient::getState(std::string value)
 
 std::vector<std::string> RedisClient::splitString(const char* s) {
     std::vector<std::string> tokens; // Vector to store the resulting substrings
-    std::string token;               // Temporary string to hold each token
-    std::stringstream ss(s);         // Create a stringstream from the input string
 
-    // Use std::getline to read from the stringstream until the delimiter is found
-    // Each read segment is stored in 'token'
-    while (std::getline(ss, token, ':')) {
-        tokens.push_back(token); // Add the extracted token to the vector
+    // Walk the ':' separated tokens in place, same splitting rules as std::getline
+    for (std::string_view token : RedisTokenRange(s)) {
+        tokens.emplace_back(token); // Add the extracted token to the vector
     }
 
     return tokens; // Return the vector of substrings
@@ -0,0 +1,285 @@
+#include "redisClientCache.h"
+
+// System Includes
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+
+// Project Includes
+#include "redisReply.h"
+
+RedisClientCache::RedisClientCache(std::string host, int port, RedisCacheConfig config)
+    : serverHost(host), serverPort(port), capacity(std::max<size_t>(config.capacity, 1)),
+      entries(new Entry[capacity])
+{
+    freeEntries.reserve(capacity);
+    for (size_t i = capacity; i > 0; --i) {
+        freeEntries.push_back(i - 1);
+    }
+    index.reserve(capacity);
+
+    try {
+        connect();
+    } catch (...) {
+        redisFree(context);
+        throw;
+    }
+    invalidationThread = std::thread(&RedisClientCache::invalidationLoop, this);
+}
+
+RedisClientCache::~RedisClientCache()
+{
+    running.store(false);
+    if (invalidationThread.joinable()) {
+        invalidationThread.join();
+    }
+    redisFree(context);
+}
+
+void RedisClientCache::connect()
+{
+    // Called with contextMutex held, or from the constructor
+    if (context == nullptr) {
+        redisOptions options{};
+        REDIS_OPTIONS_SET_TCP(&options, serverHost.c_str(), serverPort);
+        options.push_cb = &RedisClientCache::onPush;
+        options.privdata = this;
+        context = redisConnectWithOptions(&options);
+        if (context == nullptr) {
+            throw std::runtime_error("Could not connect Redis client cache");
+        }
+    } else if (redisReconnect(context) != REDIS_OK) {
+        throw std::runtime_error("Could not reconnect Redis client cache");
+    }
+    broken = true;
+    if (context->err) {
+        throw std::runtime_error("Could not connect Redis client cache");
+    }
+
+    // Invalidations arrive as RESP3 pushes on this same connection
+    RedisReplyPtr hello(static_cast<redisReply*>(redisCommand(context, "HELLO 3")));
+    if (!hello || hello->type == REDIS_REPLY_ERROR) {
+        throw std::runtime_error("Server does not support RESP3, client cache unavailable");
+    }
+    RedisReplyPtr tracking(static_cast<redisReply*>(redisCommand(context, "CLIENT TRACKING ON")));
+    if (!tracking || tracking->type == REDIS_REPLY_ERROR) {
+        throw std::runtime_error("Server does not support client tracking, client cache unavailable");
+    }
+    broken = false;
+}
+
+void RedisClientCache::markBroken()
+{
+    // Invalidations may have been lost with the connection, nothing cached can be trusted
+    if (!broken) {
+        broken = true;
+        clear();
+        flushes.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::optional<std::string> RedisClientCache::get(const std::string& key)
+{
+    std::optional<std::string> value;
+    if (lookup(key, value)) {
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return value;
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+
+    // Storing under the connection lock keeps the entry ordered with any invalidate
+    // push for the key that follows the reply
+    std::lock_guard<std::mutex> lock(contextMutex);
+    if (broken) {
+        connect();
+    }
+
+    const char* argv[] = {"GET", key.data()};
+    const size_t argvlen[] = {3, key.size()};
+    RedisReplyPtr reply(static_cast<redisReply*>(redisCommandArgv(context, 2, argv, argvlen)));
+    if (!reply) {
+        markBroken();
+        throw std::runtime_error("Failed to execute cached GET");
+    }
+
+    if (reply->type == REDIS_REPLY_STRING) {
+        value = std::string(reply->str, reply->len);
+    } else if (reply->type != REDIS_REPLY_NIL) {
+        throw std::runtime_error("Unexpected reply to cached GET");
+    }
+
+    store(key, value);
+    return value;
+}
+
+bool RedisClientCache::lookup(const std::string& key, std::optional<std::string>& value)
+{
+    std::shared_lock<std::shared_mutex> lock(entryMutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        return false;
+    }
+    Entry& entry = entries[found->second];
+    entry.referenced.store(true, std::memory_order_relaxed);
+    value = entry.value;
+    return true;
+}
+
+void RedisClientCache::store(const std::string& key, const std::optional<std::string>& value)
+{
+    std::unique_lock<std::shared_mutex> lock(entryMutex);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        entries[found->second].value = value;
+        return;
+    }
+
+    size_t slot;
+    if (!freeEntries.empty()) {
+        slot = freeEntries.back();
+        freeEntries.pop_back();
+    } else {
+        // CLOCK: give referenced entries a second chance, evict the first one that
+        // has not been read since the hand last passed it
+        while (entries[hand].referenced.exchange(false, std::memory_order_relaxed)) {
+            hand = (hand + 1) % capacity;
+        }
+        slot = hand;
+        hand = (hand + 1) % capacity;
+        index.erase(entries[slot].key);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Entry& entry = entries[slot];
+    entry.key = key;
+    entry.value = value;
+    entry.referenced.store(false, std::memory_order_relaxed);
+    index.emplace(key, slot);
+}
+
+void RedisClientCache::invalidate(const std::string& key)
+{
+    std::unique_lock<std::shared_mutex> lock(entryMutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        return;
+    }
+    Entry& entry = entries[found->second];
+    entry.key.clear();
+    entry.value.reset();
+    entry.referenced.store(false, std::memory_order_relaxed);
+    freeEntries.push_back(found->second);
+    index.erase(found);
+}
+
+void RedisClientCache::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(entryMutex);
+    for (const auto& item : index) {
+        Entry& entry = entries[item.second];
+        entry.key.clear();
+        entry.value.reset();
+        entry.referenced.store(false, std::memory_order_relaxed);
+        freeEntries.push_back(item.second);
+    }
+    index.clear();
+}
+
+void RedisClientCache::onPush(void* privdata, void* reply)
+{
+    RedisClientCache* cache = static_cast<RedisClientCache*>(privdata);
+    RedisReplyPtr push(static_cast<redisReply*>(reply));
+
+    if (push->elements < 2 || push->element[0]->str == nullptr ||
+        strcmp(push->element[0]->str, "invalidate") != 0) {
+        return;
+    }
+
+    // A nil key list means the server flushed everything
+    const redisReply* keys = push->element[1];
+    if (keys->type == REDIS_REPLY_NIL) {
+        cache->clear();
+        cache->flushes.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    for (size_t i = 0; i < keys->elements; ++i) {
+        cache->invalidate(std::string(keys->element[i]->str, keys->element[i]->len));
+        cache->invalidations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RedisClientCache::drainPushes()
+{
+    // Called with contextMutex held, only reads what is already on the socket
+    if (broken) {
+        return;
+    }
+
+    char probe;
+    ssize_t available = recv(context->fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (available < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (available <= 0 || redisBufferRead(context) != REDIS_OK) {
+        markBroken();
+        return;
+    }
+
+    // No command is in flight while we hold the lock, so everything here is a push
+    void* reply = nullptr;
+    while (redisReaderGetReply(context->reader, &reply) == REDIS_OK && reply != nullptr) {
+        if (static_cast<redisReply*>(reply)->type == REDIS_REPLY_PUSH) {
+            onPush(this, reply);
+        } else {
+            freeReplyObject(reply);
+        }
+        reply = nullptr;
+    }
+}
+
+void RedisClientCache::invalidationLoop()
+{
+    while (running.load()) {
+        int fd = -1;
+        {
+            std::lock_guard<std::mutex> lock(contextMutex);
+            if (!broken) {
+                fd = context->fd;
+            }
+        }
+        if (fd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        pollfd descriptor = {fd, POLLIN, 0};
+        if (poll(&descriptor, 1, 100) <= 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(contextMutex);
+        drainPushes();
+    }
+}
+
+size_t RedisClientCache::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(entryMutex);
+    return index.size();
+}
+
+RedisCacheMetrics RedisClientCache::metrics() const
+{
+    RedisCacheMetrics snapshot;
+    snapshot.hits = hits.load(std::memory_order_relaxed);
+    snapshot.misses = misses.load(std::memory_order_relaxed);
+    snapshot.evictions = evictions.load(std::memory_order_relaxed);
+    snapshot.invalidations = invalidations.load(std::memory_order_relaxed);
+    snapshot.flushes = flushes.load(std::memory_order_relaxed);
+    snapshot.size = size();
+    return snapshot;
+}
@@ -0,0 +1,551 @@
+#include "redisCluster.h"
+
+// System Includes
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <unordered_map>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    // CRC16-CCITT (XMODEM), the checksum Redis Cluster hashes keys with
+    constexpr std::array<uint16_t, 256> crcTable = []() {
+        std::array<uint16_t, 256> table{};
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            uint16_t crc = static_cast<uint16_t>(byte << 8);
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+            }
+            table[byte] = crc;
+        }
+        return table;
+    }();
+
+    uint16_t crc16(std::string_view data)
+    {
+        uint16_t crc = 0;
+        for (unsigned char c : data) {
+            crc = static_cast<uint16_t>((crc << 8) ^ crcTable[((crc >> 8) ^ c) & 0xff]);
+        }
+        return crc;
+    }
+
+    int64_t steadyMillis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Value of a field in a RESP2 flat key/value array or a RESP3 map
+    const redisReply* field(const redisReply* map, std::string_view name)
+    {
+        if (map == nullptr || (map->type != REDIS_REPLY_ARRAY && map->type != REDIS_REPLY_MAP)) {
+            return nullptr;
+        }
+        for (size_t i = 0; i + 1 < map->elements; i += 2) {
+            const redisReply* key = map->element[i];
+            if (key->str != nullptr && std::string_view(key->str, key->len) == name) {
+                return map->element[i + 1];
+            }
+        }
+        return nullptr;
+    }
+
+    std::string_view text(const redisReply* reply)
+    {
+        return reply != nullptr && reply->str != nullptr ? std::string_view(reply->str, reply->len) : std::string_view();
+    }
+
+    long long number(const redisReply* reply)
+    {
+        if (reply == nullptr) {
+            return -1;
+        }
+        if (reply->type == REDIS_REPLY_INTEGER) {
+            return reply->integer;
+        }
+        long long value = -1;
+        std::from_chars(reply->str, reply->str + reply->len, value);
+        return value;
+    }
+
+    struct SlotRange
+    {
+        long long start;
+        long long end;
+        std::string host;
+        int port;
+    };
+
+    // CLUSTER SHARDS, one entry per shard with its slot ranges and nodes
+    std::vector<SlotRange> parseShards(const redisReply* reply, const std::string& sourceHost)
+    {
+        std::vector<SlotRange> ranges;
+        for (size_t i = 0; i < reply->elements; ++i) {
+            const redisReply* slots = field(reply->element[i], "slots");
+            const redisReply* members = field(reply->element[i], "nodes");
+            if (slots == nullptr || members == nullptr) {
+                continue;
+            }
+
+            for (size_t n = 0; n < members->elements; ++n) {
+                const redisReply* member = members->element[n];
+                std::string_view role = text(field(member, "role"));
+                const redisReply* health = field(member, "health");
+                if ((role != "master" && role != "primary") || (health != nullptr && text(health) != "online")) {
+                    continue;
+                }
+
+                std::string_view host = text(field(member, "endpoint"));
+                if (host.empty() || host == "?") {
+                    host = text(field(member, "ip"));
+                }
+                int port = static_cast<int>(number(field(member, "port")));
+                if (port <= 0) {
+                    continue;
+                }
+                for (size_t s = 0; s + 1 < slots->elements; s += 2) {
+                    ranges.push_back({number(slots->element[s]), number(slots->element[s + 1]),
+                                      host.empty() ? sourceHost : std::string(host), port});
+                }
+                break;
+            }
+        }
+        return ranges;
+    }
+
+    // CLUSTER SLOTS, one entry per range with the primary first
+    std::vector<SlotRange> parseSlots(const redisReply* reply, const std::string& sourceHost)
+    {
+        std::vector<SlotRange> ranges;
+        for (size_t i = 0; i < reply->elements; ++i) {
+            const redisReply* range = reply->element[i];
+            if (range->type != REDIS_REPLY_ARRAY || range->elements < 3 ||
+                range->element[2]->type != REDIS_REPLY_ARRAY || range->element[2]->elements < 2) {
+                continue;
+            }
+            const redisReply* primary = range->element[2];
+            std::string_view host = text(primary->element[0]);
+            ranges.push_back({number(range->element[0]), number(range->element[1]),
+                              host.empty() ? sourceHost : std::string(host),
+                              static_cast<int>(number(primary->element[1]))});
+        }
+        return ranges;
+    }
+
+    struct ArgvArrays
+    {
+        std::vector<const char*> argv;
+        std::vector<size_t> lengths;
+
+        explicit ArgvArrays(const std::vector<std::string>& command)
+        {
+            argv.reserve(command.size());
+            lengths.reserve(command.size());
+            for (const auto& arg : command) {
+                argv.push_back(arg.data());
+                lengths.push_back(arg.size());
+            }
+        }
+
+        int argc() const { return static_cast<int>(argv.size()); }
+    };
+}
+
+RedisCluster::RedisCluster(std::string host, int port, RedisClusterConfig config)
+    : config(config), slots(std::make_unique<std::atomic<Node*>[]>(slotCount))
+{
+    node(host, port);
+    refreshSlots();
+}
+
+RedisCluster::~RedisCluster() = default;
+
+uint16_t RedisCluster::keySlot(std::string_view key)
+{
+    // Only the part inside the first non-empty {...} is hashed, so related keys can
+    // be kept on one slot
+    size_t open = key.find('{');
+    if (open != std::string_view::npos) {
+        size_t close = key.find('}', open + 1);
+        if (close != std::string_view::npos && close != open + 1) {
+            key = key.substr(open + 1, close - open - 1);
+        }
+    }
+    return static_cast<uint16_t>(crc16(key) & (slotCount - 1));
+}
+
+RedisCluster::Node* RedisCluster::node(const std::string& host, int port)
+{
+    auto find = [this, &host, port]() -> Node* {
+        for (auto& known : nodes) {
+            if (known->port == port && known->host == host) {
+                return known.get();
+            }
+        }
+        return nullptr;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(nodeMutex);
+        if (Node* known = find()) {
+            return known;
+        }
+    }
+
+    // The pool connects every slot up front, which is done without the lock so a
+    // slow or unreachable node does not stall anyNode() and metrics()
+    auto added = std::make_unique<Node>();
+    added->host = host;
+    added->port = port;
+    added->pool = std::make_unique<RedisConnectionPool>(host, port, config.pool);
+
+    std::lock_guard<std::mutex> lock(nodeMutex);
+    if (Node* known = find()) {
+        // Another thread discovered the same node first, its pool is kept
+        return known;
+    }
+    nodes.push_back(std::move(added));
+    return nodes.back().get();
+}
+
+RedisCluster::Node* RedisCluster::anyNode() const
+{
+    std::lock_guard<std::mutex> lock(nodeMutex);
+    return nodes.front().get();
+}
+
+RedisCluster::Node* RedisCluster::nodeForSlot(uint16_t slot)
+{
+    // An uncovered slot goes to any node, which answers with MOVED
+    Node* owner = slots[slot].load(std::memory_order_acquire);
+    return owner != nullptr ? owner : anyNode();
+}
+
+void RedisCluster::refreshSlots()
+{
+    std::lock_guard<std::mutex> lock(refreshMutex);
+
+    std::vector<Node*> candidates;
+    {
+        std::lock_guard<std::mutex> nodeLock(nodeMutex);
+        for (auto& known : nodes) {
+            candidates.push_back(known.get());
+        }
+    }
+
+    for (Node* candidate : candidates) {
+        try {
+            if (loadSlots(*candidate)) {
+                refreshes.fetch_add(1, std::memory_order_relaxed);
+                lastRefresh.store(steadyMillis(), std::memory_order_relaxed);
+                return;
+            }
+        } catch (const std::exception& e) {
+            spdlog::warn("Cluster node {}:{} did not return the slot map: {}", candidate->host, candidate->port, e.what());
+        }
+    }
+    throw std::runtime_error("Could not load the cluster slot map from any node");
+}
+
+bool RedisCluster::loadSlots(Node& source)
+{
+    RedisConnectionPool::Lease lease = source.pool->acquire();
+    RedisReplyPtr reply(static_cast<redisReply*>(redisCommand(lease.get(), "CLUSTER SHARDS")));
+
+    std::vector<SlotRange> ranges;
+    if (reply && reply->type == REDIS_REPLY_ARRAY) {
+        ranges = parseShards(reply.get(), source.host);
+    } else {
+        // Servers before Redis 7 only know CLUSTER SLOTS
+        reply.reset(static_cast<redisReply*>(redisCommand(lease.get(), "CLUSTER SLOTS")));
+        if (reply && reply->type == REDIS_REPLY_ARRAY) {
+            ranges = parseSlots(reply.get(), source.host);
+        }
+    }
+    lease.release();
+
+    if (ranges.empty()) {
+        return false;
+    }
+
+    // Slots missing from the new map are cleared so they go back to any node,
+    // which answers with MOVED, rather than to an owner that gave them up
+    std::vector<Node*> owners(slotCount, nullptr);
+    for (const SlotRange& range : ranges) {
+        if (range.start < 0 || range.end >= static_cast<long long>(slotCount) || range.start > range.end) {
+            continue;
+        }
+        Node* owner = nullptr;
+        try {
+            owner = node(range.host, range.port);
+        } catch (const std::exception& e) {
+            spdlog::warn("Cluster node {}:{} is unreachable: {}", range.host, range.port, e.what());
+            continue;
+        }
+        std::fill(owners.begin() + range.start, owners.begin() + range.end + 1, owner);
+    }
+    for (size_t slot = 0; slot < slotCount; ++slot) {
+        slots[slot].store(owners[slot], std::memory_order_release);
+    }
+    return true;
+}
+
+bool RedisCluster::parseRedirect(const redisReply* reply, Redirect& redirect)
+{
+    // "MOVED <slot> <host>:<port>" or "ASK <slot> <host>:<port>", the host may be empty
+    if (reply->type != REDIS_REPLY_ERROR || reply->str == nullptr) {
+        return false;
+    }
+    std::string_view message(reply->str, reply->len);
+    if (message.rfind("MOVED ", 0) == 0) {
+        redirect.ask = false;
+        message.remove_prefix(6);
+    } else if (message.rfind("ASK ", 0) == 0) {
+        redirect.ask = true;
+        message.remove_prefix(4);
+    } else {
+        return false;
+    }
+
+    size_t space = message.find(' ');
+    size_t colon = message.rfind(':');
+    if (space == std::string_view::npos || colon == std::string_view::npos || colon < space) {
+        return false;
+    }
+    unsigned slot = 0;
+    std::from_chars(message.data(), message.data() + space, slot);
+    redirect.slot = static_cast<uint16_t>(slot & (slotCount - 1));
+    redirect.host = std::string(message.substr(space + 1, colon - space - 1));
+    redirect.port = 0;
+    std::from_chars(message.data() + colon + 1, message.data() + message.size(), redirect.port);
+    return redirect.port > 0;
+}
+
+void RedisCluster::onMoved()
+{
+    // A MOVED usually means more than one slot changed hands, reload the whole map
+    // but no more than once per refreshInterval
+    int64_t now = steadyMillis();
+    int64_t last = lastRefresh.load(std::memory_order_relaxed);
+    if (now - last < config.refreshInterval.count() ||
+        !lastRefresh.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        return;
+    }
+    try {
+        refreshSlots();
+    } catch (const std::exception& e) {
+        spdlog::warn("Cluster slot map reload failed: {}", e.what());
+    }
+}
+
+redisReply* RedisCluster::route(std::string_view key, const std::function<redisReply*(redisContext*)>& send)
+{
+    commands.fetch_add(1, std::memory_order_relaxed);
+    Node* target = key.empty() ? anyNode() : nodeForSlot(keySlot(key));
+    bool asking = false;
+
+    for (size_t redirects = 0;; ++redirects) {
+        RedisConnectionPool::Lease lease = target->pool->acquire();
+        if (asking) {
+            // ASKING only applies to the next command on this connection
+            freeReplyObject(redisCommand(lease.get(), "ASKING"));
+        }
+        redisReply* reply = send(lease.get());
+        if (reply == nullptr) {
+            throw std::runtime_error("Failed to execute cluster command");
+        }
+
+        Redirect redirect;
+        if (redirects >= config.maxRedirects || !parseRedirect(reply, redirect)) {
+            return reply;
+        }
+        lease.release();
+
+        try {
+            target = node(redirect.host.empty() ? target->host : redirect.host, redirect.port);
+        } catch (const std::exception& e) {
+            // The redirect target refuses connections, the caller gets the redirect itself
+            spdlog::warn("Cluster redirect to {}:{} failed: {}", redirect.host, redirect.port, e.what());
+            return reply;
+        }
+        freeReplyObject(reply);
+        asking = redirect.ask;
+        if (redirect.ask) {
+            asks.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            moved.fetch_add(1, std::memory_order_relaxed);
+            slots[redirect.slot].store(target, std::memory_order_release);
+            onMoved();
+        }
+    }
+}
+
+redisReply* RedisCluster::executeArgv(int argc, const char** argv, const size_t* argvlen, std::string_view key)
+{
+    return route(key, [argc, argv, argvlen](redisContext* context) {
+        return static_cast<redisReply*>(redisCommandArgv(context, argc, argv, argvlen));
+    });
+}
+
+redisReply* RedisCluster::executeArgv(const std::vector<std::string>& argv)
+{
+    if (argv.empty()) {
+        throw std::runtime_error("Empty command");
+    }
+    ArgvArrays arrays(argv);
+    return executeArgv(arrays.argc(), arrays.argv.data(), arrays.lengths.data(),
+                       argv.size() > 1 ? std::string_view(argv[1]) : std::string_view());
+}
+
+redisReply* RedisCluster::executeFormatted(const std::string& formatted, std::string_view key)
+{
+    return route(key, [&formatted](redisContext* context) {
+        redisReply* reply = nullptr;
+        if (redisAppendFormattedCommand(context, formatted.data(), formatted.size()) != REDIS_OK ||
+            redisGetReply(context, reinterpret_cast<void**>(&reply)) != REDIS_OK) {
+            return static_cast<redisReply*>(nullptr);
+        }
+        return reply;
+    });
+}
+
+std::vector<RedisReplyPtr> RedisCluster::executeBatch(const std::vector<std::vector<std::string>>& commands,
+                                                      size_t keyIndex)
+{
+    batches.fetch_add(1, std::memory_order_relaxed);
+    std::vector<RedisReplyPtr> replies(commands.size());
+
+    auto keyOf = [keyIndex](const std::vector<std::string>& command) {
+        return command.size() > keyIndex ? std::string_view(command[keyIndex]) : std::string_view();
+    };
+
+    // Group the commands by the node owning their slot, a handful of nodes so a
+    // linear scan beats a map
+    std::vector<std::pair<Node*, std::vector<size_t>>> groups;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        if (commands[i].empty()) {
+            throw std::runtime_error("Empty command");
+        }
+        std::string_view key = keyOf(commands[i]);
+        Node* owner = key.empty() ? anyNode() : nodeForSlot(keySlot(key));
+        auto group = std::find_if(groups.begin(), groups.end(),
+                                  [owner](const auto& candidate) { return candidate.first == owner; });
+        if (group == groups.end()) {
+            groups.emplace_back(owner, std::vector<size_t>());
+            group = groups.end() - 1;
+        }
+        group->second.push_back(i);
+    }
+
+    // Every node gets one pipelined write and one read pass on its own connection
+    auto runGroup = [this, &commands, &replies](Node* owner, const std::vector<size_t>& indices) {
+        RedisConnectionPool::Lease lease = owner->pool->acquire();
+        redisContext* context = lease.get();
+        for (size_t index : indices) {
+            ArgvArrays arrays(commands[index]);
+            if (redisAppendCommandArgv(context, arrays.argc(), arrays.argv.data(), arrays.lengths.data()) != REDIS_OK) {
+                throw std::runtime_error("Failed to queue cluster batch command");
+            }
+        }
+        for (size_t index : indices) {
+            redisReply* reply = nullptr;
+            if (redisGetReply(context, reinterpret_cast<void**>(&reply)) != REDIS_OK) {
+                throw std::runtime_error("Failed to execute cluster batch");
+            }
+            replies[index].reset(reply);
+        }
+    };
+
+    std::vector<std::future<void>> pending;
+    for (size_t g = 1; g < groups.size(); ++g) {
+        pending.push_back(std::async(std::launch::async, runGroup, groups[g].first, std::cref(groups[g].second)));
+    }
+    if (!groups.empty()) {
+        runGroup(groups[0].first, groups[0].second);
+    }
+    for (auto& group : pending) {
+        group.get();
+    }
+    this->commands.fetch_add(commands.size(), std::memory_order_relaxed);
+
+    // Commands caught by a slot migration are sent again on their own, which follows
+    // MOVED and ASK
+    for (size_t i = 0; i < commands.size(); ++i) {
+        Redirect redirect;
+        if (replies[i] && parseRedirect(replies[i].get(), redirect)) {
+            ArgvArrays arrays(commands[i]);
+            replies[i].reset(executeArgv(arrays.argc(), arrays.argv.data(), arrays.lengths.data(), keyOf(commands[i])));
+        }
+    }
+    return replies;
+}
+
+std::vector<std::optional<std::string>> RedisCluster::mget(const std::vector<std::string>& keys)
+{
+    // Keys of one MGET must share a slot
+    std::vector<std::vector<std::string>> commands;
+    std::vector<std::vector<size_t>> positions;
+    std::unordered_map<uint16_t, size_t> bySlot;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto found = bySlot.emplace(keySlot(keys[i]), commands.size());
+        if (found.second) {
+            commands.push_back({"MGET"});
+            positions.emplace_back();
+        }
+        commands[found.first->second].push_back(keys[i]);
+        positions[found.first->second].push_back(i);
+    }
+
+    std::vector<RedisReplyPtr> replies = executeBatch(commands);
+    std::vector<std::optional<std::string>> values(keys.size());
+    for (size_t c = 0; c < replies.size(); ++c) {
+        const redisReply* reply = replies[c].get();
+        if (reply == nullptr || reply->type != REDIS_REPLY_ARRAY || reply->elements != positions[c].size()) {
+            throw std::runtime_error(reply && reply->str ? reply->str : "Failed to execute cluster MGET");
+        }
+        for (size_t j = 0; j < reply->elements; ++j) {
+            const redisReply* value = reply->element[j];
+            if (value->type == REDIS_REPLY_STRING) {
+                values[positions[c][j]] = std::string(value->str, value->len);
+            }
+        }
+    }
+    return values;
+}
+
+RedisConnectionPool::Lease RedisCluster::acquire(std::string_view key)
+{
+    Node* owner = key.empty() ? anyNode() : nodeForSlot(keySlot(key));
+    return owner->pool->acquire();
+}
+
+std::string RedisCluster::nodeFor(std::string_view key) const
+{
+    Node* owner = slots[keySlot(key)].load(std::memory_order_acquire);
+    if (owner == nullptr) {
+        owner = anyNode();
+    }
+    return owner->host + ":" + std::to_string(owner->port);
+}
+
+RedisClusterMetrics RedisCluster::metrics() const
+{
+    RedisClusterMetrics snapshot;
+    snapshot.commands = commands.load(std::memory_order_relaxed);
+    snapshot.moved = moved.load(std::memory_order_relaxed);
+    snapshot.asks = asks.load(std::memory_order_relaxed);
+    snapshot.refreshes = refreshes.load(std::memory_order_relaxed);
+    snapshot.batches = batches.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(nodeMutex);
+        snapshot.nodes = nodes.size();
+    }
+    return snapshot;
+}
@@ -0,0 +1,248 @@
+#include "redisConnectionPool.h"
+
+// System Includes
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    // Stable small number per thread, used to pick the thread's sticky connection
+    size_t threadOrdinal()
+    {
+        static std::atomic<size_t> nextOrdinal{0};
+        thread_local size_t ordinal = nextOrdinal.fetch_add(1, std::memory_order_relaxed);
+        return ordinal;
+    }
+}
+
+RedisConnectionPool::Lease::Lease(RedisConnectionPool* pool, size_t slot)
+    : pool(pool), slot(slot)
+{
+}
+
+RedisConnectionPool::Lease::~Lease()
+{
+    release();
+}
+
+RedisConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), slot(other.slot)
+{
+    other.pool = nullptr;
+}
+
+RedisConnectionPool::Lease& RedisConnectionPool::Lease::operator=(Lease&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        slot = other.slot;
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+redisContext* RedisConnectionPool::Lease::get() const
+{
+    return pool ? pool->slots[slot].context : nullptr;
+}
+
+redisContext* RedisConnectionPool::Lease::operator->() const
+{
+    return get();
+}
+
+RedisReplyArena* RedisConnectionPool::Lease::arena() const
+{
+    return pool ? pool->slots[slot].arena.get() : nullptr;
+}
+
+RedisConnectionPool::Lease::operator bool() const
+{
+    return pool != nullptr;
+}
+
+void RedisConnectionPool::Lease::release()
+{
+    if (pool) {
+        pool->release(slot);
+        pool = nullptr;
+    }
+}
+
+RedisConnectionPool::RedisConnectionPool(std::string host, int port, RedisPoolConfig config)
+    : serverHost(host), serverPort(port), config(config),
+      poolSize(config.size > 0 ? config.size : std::max(1u, std::thread::hardware_concurrency())),
+      slots(new Slot[poolSize]), target{host, port}
+{
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < poolSize; ++i) {
+        slots[i].context = redisConnect(serverHost.c_str(), serverPort);
+        slots[i].arena = std::make_unique<RedisReplyArena>();
+        slots[i].lastChecked = now;
+        if (slots[i].context == nullptr || slots[i].context->err) {
+            for (size_t j = 0; j <= i; ++j) {
+                redisFree(slots[j].context);
+            }
+            throw std::runtime_error("Could not connect Redis connection pool");
+        }
+        redisSetOutputBufferRetention(slots[i].context, REDIS_OBUF_MAX_RETAIN);
+    }
+}
+
+RedisConnectionPool::~RedisConnectionPool()
+{
+    for (size_t i = 0; i < poolSize; ++i) {
+        redisFree(slots[i].context);
+    }
+}
+
+bool RedisConnectionPool::tryClaim(size_t slot)
+{
+    // Cheap relaxed read first so a busy slot does not bounce its cache line
+    if (slots[slot].busy.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    bool expected = false;
+    return slots[slot].busy.compare_exchange_strong(expected, true, std::memory_order_acquire);
+}
+
+RedisConnectionPool::Lease RedisConnectionPool::acquire()
+{
+    acquires.fetch_add(1, std::memory_order_relaxed);
+    size_t preferred = threadOrdinal() % poolSize;
+
+    if (tryClaim(preferred)) {
+        stickyHits.fetch_add(1, std::memory_order_relaxed);
+        inUse.fetch_add(1, std::memory_order_relaxed);
+        ensureHealthy(slots[preferred], false);
+        recordWait(0);
+        return Lease(this, preferred);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + config.acquireTimeout;
+    bool waited = false;
+
+    for (unsigned spins = 0;; ++spins) {
+        for (size_t offset = 1; offset <= poolSize; ++offset) {
+            size_t slot = (preferred + offset) % poolSize;
+            if (tryClaim(slot)) {
+                auto waitedFor = std::chrono::steady_clock::now() - start;
+                recordWait(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(waitedFor).count()));
+                inUse.fetch_add(1, std::memory_order_relaxed);
+                ensureHealthy(slots[slot], false);
+                return Lease(this, slot);
+            }
+        }
+
+        if (!waited) {
+            waited = true;
+            contended.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            timeouts.fetch_add(1, std::memory_order_relaxed);
+            throw std::runtime_error("Timed out waiting for a Redis connection");
+        }
+
+        // Every connection is busy, back off from spinning to yielding
+        if (spins < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+void RedisConnectionPool::release(size_t slot)
+{
+    inUse.fetch_sub(1, std::memory_order_relaxed);
+    slots[slot].busy.store(false, std::memory_order_release);
+}
+
+bool RedisConnectionPool::ensureHealthy(Slot& slot, bool force)
+{
+    auto now = std::chrono::steady_clock::now();
+    bool broken = slot.context->err != 0;
+
+    // A connection left on the previous server is reconnected without a PING
+    uint64_t generation = targetGeneration.load(std::memory_order_acquire);
+    if (slot.generation != generation) {
+        std::lock_guard<std::mutex> lock(targetMutex);
+        RedisReconnector::retarget(slot.context, target);
+        slot.generation = generation;
+        broken = true;
+    }
+
+    if (!broken && (force || now - slot.lastChecked >= config.healthCheckInterval)) {
+        healthChecks.fetch_add(1, std::memory_order_relaxed);
+        redisReply* reply = static_cast<redisReply*>(redisCommand(slot.context, "PING"));
+        broken = reply == nullptr || reply->type == REDIS_REPLY_ERROR;
+        freeReplyObject(reply);
+    }
+    slot.lastChecked = now;
+
+    if (!broken) {
+        return true;
+    }
+
+    reconnects.fetch_add(1, std::memory_order_relaxed);
+    return redisReconnect(slot.context) == REDIS_OK;
+}
+
+void RedisConnectionPool::moveTo(const RedisEndpoint& endpoint)
+{
+    std::lock_guard<std::mutex> lock(targetMutex);
+    if (endpoint.host == target.host && endpoint.port == target.port) {
+        return;
+    }
+    target = endpoint;
+    targetGeneration.fetch_add(1, std::memory_order_release);
+}
+
+size_t RedisConnectionPool::checkHealth()
+{
+    size_t repaired = 0;
+    for (size_t i = 0; i < poolSize; ++i) {
+        // Connections in use are checked when they are next acquired
+        if (!tryClaim(i)) {
+            continue;
+        }
+        uint64_t before = reconnects.load(std::memory_order_relaxed);
+        if (ensureHealthy(slots[i], true) && reconnects.load(std::memory_order_relaxed) != before) {
+            ++repaired;
+        }
+        slots[i].busy.store(false, std::memory_order_release);
+    }
+    return repaired;
+}
+
+void RedisConnectionPool::recordWait(uint64_t nanos)
+{
+    totalWaitNanos.fetch_add(nanos, std::memory_order_relaxed);
+    uint64_t current = maxWaitNanos.load(std::memory_order_relaxed);
+    while (nanos > current &&
+           !maxWaitNanos.compare_exchange_weak(current, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+size_t RedisConnectionPool::size() const
+{
+    return poolSize;
+}
+
+RedisPoolMetrics RedisConnectionPool::metrics() const
+{
+    RedisPoolMetrics snapshot;
+    snapshot.acquires = acquires.load(std::memory_order_relaxed);
+    snapshot.stickyHits = stickyHits.load(std::memory_order_relaxed);
+    snapshot.contended = contended.load(std::memory_order_relaxed);
+    snapshot.timeouts = timeouts.load(std::memory_order_relaxed);
+    snapshot.totalWaitNanos = totalWaitNanos.load(std::memory_order_relaxed);
+    snapshot.maxWaitNanos = maxWaitNanos.load(std::memory_order_relaxed);
+    snapshot.healthChecks = healthChecks.load(std::memory_order_relaxed);
+    snapshot.reconnects = reconnects.load(std::memory_order_relaxed);
+    snapshot.inUse = inUse.load(std::memory_order_relaxed);
+    return snapshot;
+}
@@ -0,0 +1,300 @@
+#include "redisDecode.h"
+
+// System Includes
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Returned to the reader for every decoded value, the values themselves live in
+    // the sinks' targets. hiredis looks at the type of a finished reply to spot push
+    // messages, so the marker is shaped like a reply that is never one
+    redisReply decoded = []() {
+        redisReply marker{};
+        marker.type = REDIS_REPLY_NIL;
+        return marker;
+    }();
+
+    // Push replies are still built on the heap for the push callbacks
+    bool inPushReply(const redisReadTask* task)
+    {
+        while (task->parent != nullptr) {
+            task = task->parent;
+        }
+        return task->type == REDIS_REPLY_PUSH;
+    }
+
+    size_t depthOf(const redisReadTask* task)
+    {
+        size_t depth = 0;
+        for (; task->parent != nullptr; task = task->parent) {
+            ++depth;
+        }
+        return depth;
+    }
+
+    const char* typeName(int type)
+    {
+        switch (type) {
+            case REDIS_REPLY_STRING: return "string";
+            case REDIS_REPLY_ARRAY: return "array";
+            case REDIS_REPLY_INTEGER: return "integer";
+            case REDIS_REPLY_NIL: return "nil";
+            case REDIS_REPLY_STATUS: return "status";
+            case REDIS_REPLY_ERROR: return "error";
+            case REDIS_REPLY_DOUBLE: return "double";
+            case REDIS_REPLY_BOOL: return "boolean";
+            case REDIS_REPLY_MAP: return "map";
+            case REDIS_REPLY_SET: return "set";
+            case REDIS_REPLY_PUSH: return "push";
+            case REDIS_REPLY_BIGNUM: return "big number";
+            case REDIS_REPLY_VERB: return "verbatim string";
+            default: return "unknown";
+        }
+    }
+
+    // Takes the elements of an aggregate nobody wants, shared since it keeps no state
+    class IgnoreSink : public RedisDecodeSink
+    {
+
+    public:
+
+        void string(int, const char*, size_t) override {}
+        void integer(long long) override {}
+        void number(double) override {}
+        void nil() override {}
+        void boolean(bool) override {}
+        RedisDecodeSink* array(int, size_t) override { return this; }
+
+    };
+}
+
+redisReplyObjectFunctions RedisDecodeSink::Binding::functions = {
+    &RedisDecodeSink::Binding::createString,
+    &RedisDecodeSink::Binding::createArray,
+    &RedisDecodeSink::Binding::createInteger,
+    &RedisDecodeSink::Binding::createDouble,
+    &RedisDecodeSink::Binding::createNil,
+    &RedisDecodeSink::Binding::createBool,
+    &RedisDecodeSink::Binding::freeObject
+};
+
+RedisDecodeSink::Binding::Binding(redisContext* context, RedisDecodeSink& sink)
+    : reader(context->reader), previousFunctions(context->reader->fn),
+      previousPrivdata(context->reader->privdata), levels{&sink}
+{
+    // Switching functions halfway through a reply would mix decoded and heap nodes
+    if (reader->ridx != -1) {
+        throw std::runtime_error("Cannot bind a reply decoder in the middle of a reply");
+    }
+    reader->fn = &functions;
+    reader->privdata = this;
+}
+
+RedisDecodeSink::Binding::~Binding()
+{
+    // A reply cut short by an error holds decoder markers, drop it rather than let
+    // the heap functions free it later
+    if (reader->ridx != -1 && !inPushReply(reader->task[0])) {
+        reader->ridx = -1;
+        reader->reply = nullptr;
+    }
+    reader->fn = previousFunctions;
+    reader->privdata = previousPrivdata;
+}
+
+RedisDecodeSink::Binding* RedisDecodeSink::Binding::bindingOf(const redisReadTask* task)
+{
+    return static_cast<Binding*>(task->privdata);
+}
+
+RedisDecodeSink* RedisDecodeSink::Binding::sinkFor(const redisReadTask* task) const
+{
+    // Aggregates always open their depth before any element arrives
+    return levels[depthOf(task)];
+}
+
+void* RedisDecodeSink::Binding::createString(const redisReadTask* task, char* str, size_t len)
+{
+    Binding* binding = bindingOf(task);
+    if (inPushReply(task)) {
+        return binding->previousFunctions->createString(task, str, len);
+    }
+
+    // Verbatim strings carry a "txt:" style type prefix
+    if (task->type == REDIS_REPLY_VERB && len >= 4) {
+        str += 4;
+        len -= 4;
+    }
+    binding->sinkFor(task)->string(task->type, str, len);
+    return &decoded;
+}
+
+void* RedisDecodeSink::Binding::createArray(const redisReadTask* task, size_t elements)
+{
+    Binding* binding = bindingOf(task);
+    if (inPushReply(task)) {
+        return binding->previousFunctions->createArray(task, elements);
+    }
+
+    RedisDecodeSink* sink = binding->sinkFor(task)->array(task->type, elements);
+    size_t depth = depthOf(task) + 1;
+    if (binding->levels.size() <= depth) {
+        binding->levels.resize(depth + 1);
+    }
+    binding->levels[depth] = sink;
+    return &decoded;
+}
+
+void* RedisDecodeSink::Binding::createInteger(const redisReadTask* task, long long value)
+{
+    Binding* binding = bindingOf(task);
+    if (inPushReply(task)) {
+        return binding->previousFunctions->createInteger(task, value);
+    }
+    binding->sinkFor(task)->integer(value);
+    return &decoded;
+}
+
+void* RedisDecodeSink::Binding::createDouble(const redisReadTask* task, double value, char* str, size_t len)
+{
+    Binding* binding = bindingOf(task);
+    if (inPushReply(task)) {
+        return binding->previousFunctions->createDouble(task, value, str, len);
+    }
+    binding->sinkFor(task)->number(value);
+    return &decoded;
+}
+
+void* RedisDecodeSink::Binding::createNil(const redisReadTask* task)
+{
+    Binding* binding = bindingOf(task);
+    if (inPushReply(task)) {
+        return binding->previousFunctions->createNil(task);
+    }
+    binding->sinkFor(task)->nil();
+    return &decoded;
+}
+
+void* RedisDecodeSink::Binding::createBool(const redisReadTask* task, int value)
+{
+    Binding* binding = bindingOf(task);
+    if (inPushReply(task)) {
+        return binding->previousFunctions->createBool(task, value);
+    }
+    binding->sinkFor(task)->boolean(value != 0);
+    return &decoded;
+}
+
+void RedisDecodeSink::Binding::freeObject(void* reply)
+{
+    // Only push replies were built on the heap
+    if (reply != &decoded) {
+        freeReplyObject(reply);
+    }
+}
+
+void RedisDecodeSink::string(int type, const char* str, size_t len)
+{
+    if (!isError(type, str, len)) {
+        mismatch(nullptr, type);
+    }
+}
+
+void RedisDecodeSink::integer(long long)
+{
+    mismatch(nullptr, REDIS_REPLY_INTEGER);
+}
+
+void RedisDecodeSink::number(double)
+{
+    mismatch(nullptr, REDIS_REPLY_DOUBLE);
+}
+
+void RedisDecodeSink::nil()
+{
+    mismatch(nullptr, REDIS_REPLY_NIL);
+}
+
+void RedisDecodeSink::boolean(bool)
+{
+    mismatch(nullptr, REDIS_REPLY_BOOL);
+}
+
+RedisDecodeSink* RedisDecodeSink::array(int type, size_t)
+{
+    mismatch(nullptr, type);
+    return ignore();
+}
+
+void RedisDecodeSink::decode(const redisReply* reply)
+{
+    switch (reply->type) {
+        case REDIS_REPLY_STRING:
+        case REDIS_REPLY_STATUS:
+        case REDIS_REPLY_ERROR:
+        case REDIS_REPLY_BIGNUM:
+        case REDIS_REPLY_VERB:
+            string(reply->type, reply->str, reply->len);
+            break;
+        case REDIS_REPLY_INTEGER:
+            integer(reply->integer);
+            break;
+        case REDIS_REPLY_DOUBLE:
+            number(reply->dval);
+            break;
+        case REDIS_REPLY_NIL:
+            nil();
+            break;
+        case REDIS_REPLY_BOOL:
+            boolean(reply->integer != 0);
+            break;
+        default: {
+            // Maps hold their keys and values as one flat element list, as the reader sends them
+            RedisDecodeSink* elements = array(reply->type, reply->elements);
+            for (size_t i = 0; i < reply->elements; ++i) {
+                elements->decode(reply->element[i]);
+            }
+            break;
+        }
+    }
+}
+
+void RedisDecodeSink::check() const
+{
+    if (!failure.empty()) {
+        throw std::runtime_error(failure);
+    }
+}
+
+void RedisDecodeSink::fail(std::string message)
+{
+    // The first failure explains the rest
+    if (owner->failure.empty()) {
+        owner->failure = std::move(message);
+    }
+}
+
+void RedisDecodeSink::mismatch(const char* expected, int type)
+{
+    if (expected == nullptr) {
+        fail(std::string("Unexpected ") + typeName(type) + " reply");
+        return;
+    }
+    fail(std::string("Expected ") + expected + " reply, got " + typeName(type));
+}
+
+bool RedisDecodeSink::isError(int type, const char* str, size_t len)
+{
+    if (type != REDIS_REPLY_ERROR) {
+        return false;
+    }
+    fail(std::string(str, len));
+    return true;
+}
+
+RedisDecodeSink* RedisDecodeSink::ignore()
+{
+    static IgnoreSink sink;
+    return &sink;
+}
@@ -0,0 +1,178 @@
+#include "redisDispatcher.h"
+
+// System Includes
+#include <chrono>
+#include <stdexcept>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    // The channel a message was published on, pmessage carries the pattern first
+    std::string_view channelOf(const redisReply* message)
+    {
+        size_t index = message->elements == 4 ? 2 : 1;
+        if (message->elements <= index || message->element[index]->str == nullptr) {
+            return std::string_view();
+        }
+        return std::string_view(message->element[index]->str, message->element[index]->len);
+    }
+}
+
+RedisMessageDispatcher::RedisMessageDispatcher(RedisDispatchConfig config, Handler handler)
+    : config(config), handler(std::move(handler))
+{
+    if (config.workers == 0) {
+        throw std::runtime_error("Dispatcher needs at least one worker");
+    }
+
+    workers.reserve(config.workers);
+    for (size_t i = 0; i < config.workers; ++i) {
+        workers.push_back(std::make_unique<Worker>(config.queueCapacity));
+    }
+    for (auto& worker : workers) {
+        Worker& target = *worker;
+        worker->thread = std::thread([this, &target]() { workerLoop(target); });
+    }
+}
+
+RedisMessageDispatcher::~RedisMessageDispatcher()
+{
+    stop();
+}
+
+void RedisMessageDispatcher::stop()
+{
+    running.store(false);
+    for (auto& worker : workers) {
+        notify(*worker);
+    }
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+size_t RedisMessageDispatcher::workerFor(std::string_view channel) const
+{
+    return std::hash<std::string_view>()(channel) % workers.size();
+}
+
+void RedisMessageDispatcher::dispatch(RedisReplyPtr message, std::chrono::steady_clock::time_point received)
+{
+    if (!message) {
+        return;
+    }
+    dispatched.fetch_add(1, std::memory_order_relaxed);
+    Worker& worker = *workers[workerFor(channelOf(message.get()))];
+
+    Delivery delivery{message.release(), received};
+    if (!worker.queue.tryPush(std::move(delivery))) {
+        if (config.overflow == OverflowPolicy::DropNewest) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            freeReplyObject(delivery.message);
+            return;
+        }
+
+        if (config.overflow == OverflowPolicy::Block) {
+            blocked.fetch_add(1, std::memory_order_relaxed);
+            waitForSpace(worker, delivery);
+        } else {
+            while (!worker.queue.tryPush(std::move(delivery))) {
+                Delivery oldest;
+                if (worker.queue.tryPop(oldest)) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    freeReplyObject(oldest.message);
+                }
+            }
+        }
+    }
+
+    notify(worker);
+}
+
+void RedisMessageDispatcher::notify(Worker& worker)
+{
+    // Pairs with the fence in workerLoop, either the worker sees the new message or
+    // we see it going to sleep and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.wake.notify_one();
+    }
+}
+
+void RedisMessageDispatcher::waitForSpace(Worker& worker, Delivery& delivery)
+{
+    // Same handshake as notify, mirrored: either the worker sees full after freeing a
+    // cell and signals space, or the push below sees the freed cell
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    worker.full.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!worker.queue.tryPush(std::move(delivery))) {
+        // The mutex is held, so the worker is either draining or already waiting
+        worker.wake.notify_one();
+        worker.space.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    worker.full.store(false, std::memory_order_relaxed);
+}
+
+void RedisMessageDispatcher::workerLoop(Worker& worker)
+{
+    Delivery delivery;
+
+    for (;;) {
+        if (worker.queue.tryPop(delivery)) {
+            if (config.overflow == OverflowPolicy::Block) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (worker.full.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lock(worker.mutex);
+                    worker.space.notify_one();
+                }
+            }
+            try {
+                handler(delivery.message, delivery.received);
+            } catch (const std::exception& e) {
+                spdlog::error("Subscriber handler failed: {}", e.what());
+            }
+            freeReplyObject(delivery.message);
+            delivered.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Queued messages are still delivered after stop()
+        if (!running.load()) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.queue.empty() && running.load()) {
+            worker.wake.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        worker.sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+size_t RedisMessageDispatcher::queueDepth() const
+{
+    size_t depth = 0;
+    for (const auto& worker : workers) {
+        depth += worker->queue.size();
+    }
+    return depth;
+}
+
+RedisDispatchMetrics RedisMessageDispatcher::metrics() const
+{
+    RedisDispatchMetrics snapshot;
+    snapshot.dispatched = dispatched.load(std::memory_order_relaxed);
+    snapshot.delivered = delivered.load(std::memory_order_relaxed);
+    snapshot.dropped = dropped.load(std::memory_order_relaxed);
+    snapshot.blocked = blocked.load(std::memory_order_relaxed);
+    snapshot.queueDepth = queueDepth();
+    return snapshot;
+}
@@ -0,0 +1,350 @@
+#include "redisEventLoop.h"
+
+// System Includes
+#include <future>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+RedisEventLoop::RedisEventLoop()
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error("Could not create epoll instance");
+    }
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        close(epollFd);
+        throw std::runtime_error("Could not create event loop wake descriptor");
+    }
+
+    // The wake descriptor is the only registration without a Watch
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+RedisEventLoop::~RedisEventLoop()
+{
+    stop();
+    releaseRetired();
+
+    // Contexts that are still attached must not call back into a destroyed loop
+    for (Watch* watch : watches) {
+        if (watch->context) {
+            watch->context->ev = {};
+        }
+        delete watch;
+    }
+    watches.clear();
+
+    close(wakeFd);
+    close(epollFd);
+}
+
+void RedisEventLoop::attach(redisAsyncContext* context)
+{
+    if (context == nullptr) {
+        throw std::runtime_error("Async context not initialized");
+    }
+    if (context->ev.data != nullptr) {
+        throw std::runtime_error("Async context is already attached to an event loop");
+    }
+
+    Watch* watch = new Watch{this, context, context->c.fd, 0, false, false, {}};
+    watches.push_back(watch);
+
+    context->ev.data = watch;
+    context->ev.addRead = &RedisEventLoop::addRead;
+    context->ev.delRead = &RedisEventLoop::delRead;
+    context->ev.addWrite = &RedisEventLoop::addWrite;
+    context->ev.delWrite = &RedisEventLoop::delWrite;
+    context->ev.cleanup = &RedisEventLoop::cleanup;
+    context->ev.scheduleTimer = &RedisEventLoop::scheduleTimer;
+
+    // Wait for writability so a pending non-blocking connect completes and any
+    // commands queued before the context was attached are flushed
+    updateInterest(watch, EPOLLOUT);
+}
+
+void RedisEventLoop::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        if (running.load()) {
+            return; // Already running
+        }
+        running.store(true);
+    }
+    loopThread = std::thread([this]() {
+        while (running.load()) {
+            runOnce(-1);
+        }
+        runTasks();
+    });
+}
+
+void RedisEventLoop::stop()
+{
+    // Cleared under the task lock, a task invoke() queued before this is run by the
+    // loop on its way out and any invoke() after it runs its task inline
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        running.store(false);
+    }
+    wake();
+
+    if (loopThread.joinable() && loopThread.get_id() != std::this_thread::get_id()) {
+        loopThread.join();
+    }
+}
+
+void RedisEventLoop::run()
+{
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        running.store(true);
+    }
+    while (running.load()) {
+        runOnce(-1);
+    }
+    runTasks();
+}
+
+bool RedisEventLoop::isRunning() const
+{
+    return running.load();
+}
+
+bool RedisEventLoop::inLoopThread() const
+{
+    return loopThreadId.load() == std::this_thread::get_id();
+}
+
+void RedisEventLoop::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        tasks.push_back(std::move(task));
+    }
+    wake();
+}
+
+void RedisEventLoop::invoke(std::function<void()> task)
+{
+    if (inLoopThread()) {
+        task();
+        return;
+    }
+
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    {
+        // Checked and queued under the lock stop() takes, a loop seen running is
+        // guaranteed to run the task before it exits
+        std::unique_lock<std::mutex> lock(taskMutex);
+        if (!running.load()) {
+            lock.unlock();
+            task();
+            return;
+        }
+        tasks.push_back([&task, &done]() {
+            try {
+                task();
+                done.set_value();
+            } catch (...) {
+                done.set_exception(std::current_exception());
+            }
+        });
+    }
+    wake();
+    finished.get();
+}
+
+void RedisEventLoop::wake()
+{
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+void RedisEventLoop::runOnce(int timeoutMs)
+{
+    loopThreadId.store(std::this_thread::get_id());
+
+    struct epoll_event events[64];
+    int count = epoll_wait(epollFd, events, 64, nextTimeout(timeoutMs));
+    if (count < 0 && errno != EINTR) {
+        throw std::runtime_error("epoll_wait failed");
+    }
+
+    for (int i = 0; i < count; ++i) {
+        Watch* watch = static_cast<Watch*>(events[i].data.ptr);
+        if (watch == nullptr) {
+            uint64_t value = 0;
+            ssize_t drained = read(wakeFd, &value, sizeof(value));
+            (void)drained;
+            continue;
+        }
+
+        // A context freed by an earlier event in this batch leaves its watch retired
+        uint32_t ready = events[i].events;
+        if (watch->context && (watch->events & EPOLLIN) && (ready & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+            redisAsyncHandleRead(watch->context);
+        }
+        if (watch->context && (watch->events & EPOLLOUT) && (ready & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            redisAsyncHandleWrite(watch->context);
+        }
+    }
+
+    runTimers();
+    runTasks();
+    releaseRetired();
+}
+
+int RedisEventLoop::nextTimeout(int timeoutMs) const
+{
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        if (!tasks.empty()) {
+            return 0;
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    int timeout = timeoutMs;
+    for (const Watch* watch : watches) {
+        if (!watch->context || !watch->timerArmed) {
+            continue;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(watch->deadline - now).count();
+        int wait = remaining > 0 ? static_cast<int>(remaining) + 1 : 0;
+        if (timeout < 0 || wait < timeout) {
+            timeout = wait;
+        }
+    }
+    return timeout;
+}
+
+void RedisEventLoop::runTimers()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    // Index based, a timeout may attach or retire contexts while we iterate
+    for (size_t i = 0; i < watches.size(); ++i) {
+        Watch* watch = watches[i];
+        if (watch->context && watch->timerArmed && watch->deadline <= now) {
+            watch->timerArmed = false;
+            redisAsyncHandleTimeout(watch->context);
+        }
+    }
+}
+
+void RedisEventLoop::runTasks()
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        ready.swap(tasks);
+    }
+
+    for (auto& task : ready) {
+        task();
+    }
+}
+
+void RedisEventLoop::releaseRetired()
+{
+    for (Watch* watch : retired) {
+        for (size_t i = 0; i < watches.size(); ++i) {
+            if (watches[i] == watch) {
+                watches[i] = watches.back();
+                watches.pop_back();
+                break;
+            }
+        }
+        delete watch;
+    }
+    retired.clear();
+}
+
+void RedisEventLoop::updateInterest(Watch* watch, uint32_t events)
+{
+    if (watch->events == events) {
+        return;
+    }
+
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.ptr = watch;
+
+    if (events == 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, watch->fd, &event);
+        watch->registered = false;
+    } else if (watch->registered) {
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, watch->fd, &event);
+    } else {
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, watch->fd, &event);
+        watch->registered = true;
+    }
+    watch->events = events;
+}
+
+void RedisEventLoop::addRead(void* privdata)
+{
+    Watch* watch = static_cast<Watch*>(privdata);
+    if (watch->context) {
+        watch->loop->updateInterest(watch, watch->events | EPOLLIN);
+    }
+}
+
+void RedisEventLoop::delRead(void* privdata)
+{
+    Watch* watch = static_cast<Watch*>(privdata);
+    if (watch->context) {
+        watch->loop->updateInterest(watch, watch->events & ~static_cast<uint32_t>(EPOLLIN));
+    }
+}
+
+void RedisEventLoop::addWrite(void* privdata)
+{
+    Watch* watch = static_cast<Watch*>(privdata);
+    if (watch->context) {
+        watch->loop->updateInterest(watch, watch->events | EPOLLOUT);
+    }
+}
+
+void RedisEventLoop::delWrite(void* privdata)
+{
+    Watch* watch = static_cast<Watch*>(privdata);
+    if (watch->context) {
+        watch->loop->updateInterest(watch, watch->events & ~static_cast<uint32_t>(EPOLLOUT));
+    }
+}
+
+void RedisEventLoop::cleanup(void* privdata)
+{
+    // Called while the context is being freed, the watch itself is released at
+    // the end of the current loop iteration so pending events can still see it
+    Watch* watch = static_cast<Watch*>(privdata);
+    watch->loop->updateInterest(watch, 0);
+    watch->context = nullptr;
+    watch->timerArmed = false;
+    watch->loop->retired.push_back(watch);
+}
+
+void RedisEventLoop::scheduleTimer(void* privdata, struct timeval tv)
+{
+    Watch* watch = static_cast<Watch*>(privdata);
+    if (!watch->context) {
+        return;
+    }
+    watch->timerArmed = true;
+    watch->deadline = std::chrono::steady_clock::now() +
+                      std::chrono::seconds(tv.tv_sec) +
+                      std::chrono::microseconds(tv.tv_usec);
+}
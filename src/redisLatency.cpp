@@ -0,0 +1,335 @@
+#include "redisLatency.h"
+
+// System Includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    // Recorder ids are never reused, so a thread's cached state can't outlive its recorder
+    std::atomic<uint64_t> nextRecorderId{1};
+
+    // Recorders still alive by id. Every destruction bumps retiredRecorders, which
+    // tells each thread to drop the state it cached for recorders that are gone
+    std::mutex liveMutex;
+    std::atomic<uint64_t> retiredRecorders{0};
+
+    std::map<uint64_t, RedisLatencyRecorder*>& liveRecorders()
+    {
+        static std::map<uint64_t, RedisLatencyRecorder*> recorders;
+        return recorders;
+    }
+
+    thread_local bool threadExited = false;
+
+    double micros(uint64_t nanos)
+    {
+        return static_cast<double>(nanos) / 1000.0;
+    }
+}
+
+uint64_t RedisLatencySnapshot::percentile(double fraction) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * count));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= target) {
+            return std::min(RedisLatencyHistogram::upperBound(bucket), maxNanos);
+        }
+    }
+    return maxNanos;
+}
+
+double RedisLatencySnapshot::meanNanos() const
+{
+    return count ? static_cast<double>(totalNanos) / count : 0.0;
+}
+
+void RedisLatencySnapshot::merge(const RedisLatencySnapshot& other)
+{
+    if (buckets.size() < other.buckets.size()) {
+        buckets.resize(other.buckets.size(), 0);
+    }
+    for (size_t i = 0; i < other.buckets.size(); ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    totalNanos += other.totalNanos;
+    maxNanos = std::max(maxNanos, other.maxNanos);
+}
+
+size_t RedisLatencyHistogram::bucketOf(uint64_t nanos)
+{
+    if (nanos < subBuckets) {
+        return static_cast<size_t>(nanos);
+    }
+    unsigned magnitude = 63 - static_cast<unsigned>(__builtin_clzll(nanos));
+    unsigned shift = magnitude - subBucketBits;
+    return (shift + 1) * subBuckets + ((nanos >> shift) & (subBuckets - 1));
+}
+
+uint64_t RedisLatencyHistogram::upperBound(size_t bucket)
+{
+    if (bucket < subBuckets) {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>(bucket / subBuckets - 1);
+    uint64_t sub = bucket % subBuckets;
+    return ((subBuckets + sub + 1) << shift) - 1;
+}
+
+void RedisLatencyHistogram::record(uint64_t nanos)
+{
+    // Single writer, so plain load and store are enough and never wait
+    std::atomic<uint64_t>& bucket = counts[bucketOf(nanos)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    totalNanos.store(totalNanos.load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+    if (nanos > maxNanos.load(std::memory_order_relaxed)) {
+        maxNanos.store(nanos, std::memory_order_relaxed);
+    }
+}
+
+void RedisLatencyHistogram::addTo(RedisLatencySnapshot& snapshot) const
+{
+    if (snapshot.buckets.size() < bucketCount) {
+        snapshot.buckets.resize(bucketCount, 0);
+    }
+
+    // Summed from the buckets so count always matches what the percentiles walk
+    uint64_t recorded = 0;
+    for (size_t i = 0; i < bucketCount; ++i) {
+        uint64_t value = counts[i].load(std::memory_order_relaxed);
+        snapshot.buckets[i] += value;
+        recorded += value;
+    }
+    snapshot.count += recorded;
+    snapshot.totalNanos += totalNanos.load(std::memory_order_relaxed);
+    snapshot.maxNanos = std::max(snapshot.maxNanos, maxNanos.load(std::memory_order_relaxed));
+}
+
+// The states one thread records into, handed back to their recorders when it exits
+struct RedisLatencyThreadStates
+{
+    std::vector<std::pair<uint64_t, RedisLatencyRecorder::ThreadState*>> states;
+    uint64_t seenRetired = 0;
+
+    ~RedisLatencyThreadStates()
+    {
+        threadExited = true;
+
+        // A recorder can't be destroyed while liveMutex is held, its destructor takes it
+        std::lock_guard<std::mutex> lock(liveMutex);
+        for (const auto& state : states) {
+            auto found = liveRecorders().find(state.first);
+            if (found != liveRecorders().end()) {
+                found->second->retire(state.second);
+            }
+        }
+    }
+};
+
+RedisLatencyRecorder::ThreadState::~ThreadState()
+{
+    for (auto& histogram : histograms) {
+        delete histogram.load(std::memory_order_relaxed);
+    }
+}
+
+RedisLatencyRecorder::RedisLatencyRecorder()
+    : id(nextRecorderId.fetch_add(1, std::memory_order_relaxed))
+{
+    std::lock_guard<std::mutex> lock(liveMutex);
+    liveRecorders().emplace(id, this);
+}
+
+RedisLatencyRecorder::~RedisLatencyRecorder()
+{
+    stopDump();
+
+    std::lock_guard<std::mutex> lock(liveMutex);
+    liveRecorders().erase(id);
+    retiredRecorders.fetch_add(1, std::memory_order_release);
+}
+
+size_t RedisLatencyRecorder::metric(std::string_view name)
+{
+    size_t known = nameCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < known; ++i) {
+        if (names[i] == name) {
+            return i;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(nameMutex);
+    known = nameCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < known; ++i) {
+        if (names[i] == name) {
+            return i;
+        }
+    }
+
+    // The last slot is kept for everything past the limit
+    if (known >= maxMetrics - 1) {
+        if (known == maxMetrics - 1) {
+            names[known] = "OTHER";
+            nameCount.store(maxMetrics, std::memory_order_release);
+        }
+        return maxMetrics - 1;
+    }
+    names[known] = std::string(name);
+    nameCount.store(known + 1, std::memory_order_release);
+    return known;
+}
+
+RedisLatencyRecorder::ThreadState* RedisLatencyRecorder::local()
+{
+    // Samples recorded from other thread local destructors after ours are dropped
+    if (threadExited) {
+        return nullptr;
+    }
+    thread_local RedisLatencyThreadStates owned;
+    auto& states = owned.states;
+
+    // Pruned the next time the thread records after any recorder is destroyed, so the
+    // list does not grow with every recorder the thread has ever used
+    uint64_t retired = retiredRecorders.load(std::memory_order_acquire);
+    if (retired != owned.seenRetired) {
+        std::lock_guard<std::mutex> lock(liveMutex);
+        const auto& live = liveRecorders();
+        states.erase(std::remove_if(states.begin(), states.end(),
+                                    [&live](const std::pair<uint64_t, ThreadState*>& state) {
+                                        return live.count(state.first) == 0;
+                                    }),
+                     states.end());
+        owned.seenRetired = retired;
+    }
+
+    for (const auto& state : states) {
+        if (state.first == id) {
+            return state.second;
+        }
+    }
+
+    // First record from this thread, the recorder owns the state from here on
+    std::lock_guard<std::mutex> lock(threadMutex);
+    threads.push_back(std::make_unique<ThreadState>());
+    states.emplace_back(id, threads.back().get());
+    return threads.back().get();
+}
+
+void RedisLatencyRecorder::retire(ThreadState* state)
+{
+    // The exiting thread was the only writer, its counts are final
+    std::lock_guard<std::mutex> lock(threadMutex);
+    for (size_t i = 0; i < maxMetrics; ++i) {
+        const RedisLatencyHistogram* histogram = state->histograms[i].load(std::memory_order_acquire);
+        if (histogram != nullptr) {
+            histogram->addTo(retired[i]);
+        }
+    }
+    threads.erase(std::remove_if(threads.begin(), threads.end(),
+                                 [state](const std::unique_ptr<ThreadState>& owned) {
+                                     return owned.get() == state;
+                                 }),
+                  threads.end());
+}
+
+void RedisLatencyRecorder::record(size_t metric, uint64_t nanos)
+{
+    if (metric >= maxMetrics) {
+        return;
+    }
+    ThreadState* state = local();
+    if (state == nullptr) {
+        return;
+    }
+    std::atomic<RedisLatencyHistogram*>& slot = state->histograms[metric];
+    RedisLatencyHistogram* histogram = slot.load(std::memory_order_relaxed);
+    if (histogram == nullptr) {
+        histogram = new RedisLatencyHistogram();
+        slot.store(histogram, std::memory_order_release);
+    }
+    histogram->record(nanos);
+}
+
+void RedisLatencyRecorder::record(size_t metric, std::chrono::steady_clock::time_point start)
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    record(metric, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+std::map<std::string, RedisLatencySnapshot> RedisLatencyRecorder::snapshot() const
+{
+    std::map<std::string, RedisLatencySnapshot> merged;
+    size_t known = nameCount.load(std::memory_order_acquire);
+
+    std::lock_guard<std::mutex> lock(threadMutex);
+    for (size_t i = 0; i < known; ++i) {
+        if (retired[i].count > 0) {
+            merged[names[i]].merge(retired[i]);
+        }
+    }
+    for (const auto& state : threads) {
+        for (size_t i = 0; i < known; ++i) {
+            const RedisLatencyHistogram* histogram = state->histograms[i].load(std::memory_order_acquire);
+            if (histogram != nullptr) {
+                histogram->addTo(merged[names[i]]);
+            }
+        }
+    }
+    return merged;
+}
+
+void RedisLatencyRecorder::startDump(std::chrono::milliseconds interval)
+{
+    stopDump();
+
+    // Set under the lock the dump thread reads it with
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        dumping = true;
+    }
+    dumpThread = std::thread([this, interval]() {
+        std::unique_lock<std::mutex> lock(dumpMutex);
+        while (!dumpWake.wait_for(lock, interval, [this]() { return !dumping; })) {
+            lock.unlock();
+            dump();
+            lock.lock();
+        }
+    });
+}
+
+void RedisLatencyRecorder::stopDump()
+{
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        dumping = false;
+    }
+    dumpWake.notify_all();
+    if (dumpThread.joinable()) {
+        dumpThread.join();
+    }
+}
+
+void RedisLatencyRecorder::dump() const
+{
+    for (const auto& entry : snapshot()) {
+        const RedisLatencySnapshot& latency = entry.second;
+        spdlog::info("Latency {}: count={} mean={:.1f}us p50={:.1f}us p99={:.1f}us p999={:.1f}us max={:.1f}us",
+                     entry.first, latency.count, latency.meanNanos() / 1000.0,
+                     micros(latency.percentile(0.50)), micros(latency.percentile(0.99)),
+                     micros(latency.percentile(0.999)), micros(latency.maxNanos));
+    }
+}
@@ -0,0 +1,125 @@
+#include "redisPipeline.h"
+
+// System Includes
+#include <stdexcept>
+
+Pipeline::Pipeline(redisContext* context, RedisConnectionPool::Lease lease)
+    : lease(std::move(lease)), context(context)
+{
+    if (context == nullptr) {
+        throw std::runtime_error("Pipeline context not initialized");
+    }
+    unsentBefore = unsent();
+}
+
+Pipeline::Pipeline(Pipeline&& other) noexcept
+    : lease(std::move(other.lease)), context(other.context), pending(other.pending),
+      unsentBefore(other.unsentBefore)
+{
+    other.pending = 0;
+}
+
+Pipeline::~Pipeline()
+{
+    // Queued commands are only in the output buffer, a batch abandoned by an early
+    // return or an exception is cut from it rather than sent half built
+    if (pending == 0 || context->err) {
+        return;
+    }
+    size_t length = context->obuf_pos + unsentBefore;
+    sdssetlen(context->obuf, length);
+    context->obuf[length] = '\0';
+}
+
+size_t Pipeline::unsent() const
+{
+    // Appending may move unsent bytes to the front of the buffer, their count stays
+    return sdslen(context->obuf) - context->obuf_pos;
+}
+
+template <typename Range>
+size_t Pipeline::appendRange(const Range& argv)
+{
+    std::vector<const char*> args;
+    std::vector<size_t> lengths;
+    args.reserve(argv.size());
+    lengths.reserve(argv.size());
+
+    for (const auto& arg : argv) {
+        args.push_back(arg.data());
+        lengths.push_back(arg.size());
+    }
+
+    return appendArgv(static_cast<int>(args.size()), args.data(), lengths.data());
+}
+
+size_t Pipeline::appendArgv(int argc, const char** argv, const size_t* argvlen)
+{
+    if (redisAppendCommandArgv(context, argc, argv, argvlen) != REDIS_OK) {
+        throw std::runtime_error("Failed to queue pipelined command");
+    }
+    return pending++;
+}
+
+size_t Pipeline::appendFormatted(const std::string& command)
+{
+    if (redisAppendFormattedCommand(context, command.data(), command.size()) != REDIS_OK) {
+        throw std::runtime_error("Failed to queue pipelined command");
+    }
+    return pending++;
+}
+
+size_t Pipeline::append(std::initializer_list<std::string_view> argv)
+{
+    return appendRange(argv);
+}
+
+size_t Pipeline::append(const std::vector<std::string>& argv)
+{
+    return appendRange(argv);
+}
+
+size_t Pipeline::set(std::string_view key, std::string_view value)
+{
+    return append(RedisCommands::SET, key, value);
+}
+
+size_t Pipeline::get(std::string_view key)
+{
+    return append(RedisCommands::GET, key);
+}
+
+size_t Pipeline::publish(std::string_view channel, std::string_view message)
+{
+    return append(RedisCommands::PUBLISH, channel, message);
+}
+
+std::vector<RedisResult> Pipeline::execute()
+{
+    std::vector<RedisResult> results;
+    results.reserve(pending);
+
+    // The first redisGetReply writes the whole output buffer, the rest are
+    // served from the reader without touching the socket again
+    while (pending > 0) {
+        redisReply* reply = nullptr;
+        if (redisGetReply(context, reinterpret_cast<void**>(&reply)) != REDIS_OK) {
+            pending = 0;
+            throw std::runtime_error("Failed to execute pipeline");
+        }
+        results.emplace_back(RedisReplyPtr(reply));
+        --pending;
+    }
+
+    return results;
+}
+
+size_t Pipeline::size() const
+{
+    return pending;
+}
+
+bool Pipeline::empty() const
+{
+    return pending == 0;
+}
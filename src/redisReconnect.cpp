@@ -0,0 +1,156 @@
+#include "redisReconnect.h"
+
+// System Includes
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+
+namespace
+{
+    // Longest sleep between checks of keepTrying
+    constexpr std::chrono::milliseconds stopCheckInterval{50};
+
+    double jitterFactor(double jitter)
+    {
+        if (jitter <= 0.0) {
+            return 1.0;
+        }
+        thread_local std::mt19937 generator{std::random_device{}()};
+        std::uniform_real_distribution<double> spread(-jitter, jitter);
+        return 1.0 + spread(generator);
+    }
+}
+
+void RedisReconnectMetrics::merge(const RedisReconnectMetrics& other)
+{
+    disconnects += other.disconnects;
+    reconnects += other.reconnects;
+    failedAttempts += other.failedAttempts;
+    replayed += other.replayed;
+    totalRecoveryNanos += other.totalRecoveryNanos;
+    maxRecoveryNanos = std::max(maxRecoveryNanos, other.maxRecoveryNanos);
+}
+
+RedisReconnector::RedisReconnector(RedisReconnectConfig config)
+    : config(config)
+{
+}
+
+std::chrono::milliseconds RedisReconnector::delay(size_t retry) const
+{
+    double base = static_cast<double>(config.initialDelay.count()) *
+                  std::pow(std::max(config.multiplier, 1.0), static_cast<double>(retry));
+    base = std::min(base, static_cast<double>(config.maxDelay.count()));
+    return std::chrono::milliseconds(static_cast<int64_t>(std::max(0.0, base * jitterFactor(config.jitter))));
+}
+
+void RedisReconnector::follow(std::function<RedisEndpoint()> endpointSource)
+{
+    source = std::move(endpointSource);
+}
+
+bool RedisReconnector::retarget(redisContext* context, const RedisEndpoint& endpoint)
+{
+    if (context->connection_type != REDIS_CONN_TCP || endpoint.host.empty() ||
+        (context->tcp.host != nullptr && endpoint.host == context->tcp.host && endpoint.port == context->tcp.port)) {
+        return false;
+    }
+
+    // hiredis owns the host string, it is replaced with its own allocator
+    char* host = hi_strdup(endpoint.host.c_str());
+    if (host == nullptr) {
+        return false;
+    }
+    hi_free(context->tcp.host);
+    context->tcp.host = host;
+    context->tcp.port = endpoint.port;
+    return true;
+}
+
+void RedisReconnector::markDown()
+{
+    if (!down) {
+        down = true;
+        failures = 0;
+        downSince = std::chrono::steady_clock::now();
+        nextAttempt = downSince;
+        disconnects.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool RedisReconnector::attempt(redisContext* context)
+{
+    if (redisReconnect(context) != REDIS_OK) {
+        failedAttempts.fetch_add(1, std::memory_order_relaxed);
+        nextAttempt = std::chrono::steady_clock::now() + delay(failures++);
+        return false;
+    }
+
+    auto recovered = std::chrono::steady_clock::now() - downSince;
+    uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(recovered).count());
+    lastRecovery.store(nanos, std::memory_order_relaxed);
+    totalRecoveryNanos.fetch_add(nanos, std::memory_order_relaxed);
+    if (nanos > maxRecoveryNanos.load(std::memory_order_relaxed)) {
+        maxRecoveryNanos.store(nanos, std::memory_order_relaxed);
+    }
+    reconnects.fetch_add(1, std::memory_order_relaxed);
+    down = false;
+    return true;
+}
+
+bool RedisReconnector::reconnect(redisContext* context, const std::function<bool()>& keepTrying)
+{
+    markDown();
+    while (keepTrying()) {
+        if (config.maxAttempts > 0 && failures >= config.maxAttempts) {
+            return false;
+        }
+
+        // Sleep in short slices so a stopping owner is not held up by a long backoff,
+        // a new address is tried as soon as it shows up
+        bool moved = source && retarget(context, source());
+        auto now = std::chrono::steady_clock::now();
+        if (!moved && now < nextAttempt) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(nextAttempt - now,
+                                                                                      stopCheckInterval));
+            continue;
+        }
+        if (attempt(context)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RedisReconnector::tryReconnect(redisContext* context)
+{
+    markDown();
+    bool moved = source && retarget(context, source());
+    if (!moved && std::chrono::steady_clock::now() < nextAttempt) {
+        return false;
+    }
+    return attempt(context);
+}
+
+void RedisReconnector::countReplayed(uint64_t count)
+{
+    replayed.fetch_add(count, std::memory_order_relaxed);
+}
+
+uint64_t RedisReconnector::lastRecoveryNanos() const
+{
+    return lastRecovery.load(std::memory_order_relaxed);
+}
+
+RedisReconnectMetrics RedisReconnector::metrics() const
+{
+    RedisReconnectMetrics snapshot;
+    snapshot.disconnects = disconnects.load(std::memory_order_relaxed);
+    snapshot.reconnects = reconnects.load(std::memory_order_relaxed);
+    snapshot.failedAttempts = failedAttempts.load(std::memory_order_relaxed);
+    snapshot.replayed = replayed.load(std::memory_order_relaxed);
+    snapshot.totalRecoveryNanos = totalRecoveryNanos.load(std::memory_order_relaxed);
+    snapshot.maxRecoveryNanos = maxRecoveryNanos.load(std::memory_order_relaxed);
+    return snapshot;
+}
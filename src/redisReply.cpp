@@ -0,0 +1,90 @@
+#include "redisReply.h"
+
+// System Includes
+#include <stdexcept>
+
+RedisResult::RedisResult(RedisReplyPtr reply)
+    : reply(std::move(reply))
+{
+}
+
+bool RedisResult::isOk() const
+{
+    return reply && reply->type != REDIS_REPLY_ERROR;
+}
+
+bool RedisResult::isError() const
+{
+    return !reply || reply->type == REDIS_REPLY_ERROR;
+}
+
+bool RedisResult::isNil() const
+{
+    return reply && reply->type == REDIS_REPLY_NIL;
+}
+
+bool RedisResult::isString() const
+{
+    // Status replies such as "+OK" carry their text the same way bulk strings do
+    return reply && (reply->type == REDIS_REPLY_STRING ||
+                     reply->type == REDIS_REPLY_STATUS ||
+                     reply->type == REDIS_REPLY_VERB);
+}
+
+bool RedisResult::isInteger() const
+{
+    return reply && reply->type == REDIS_REPLY_INTEGER;
+}
+
+bool RedisResult::isArray() const
+{
+    return reply && (reply->type == REDIS_REPLY_ARRAY ||
+                     reply->type == REDIS_REPLY_SET ||
+                     reply->type == REDIS_REPLY_MAP ||
+                     reply->type == REDIS_REPLY_PUSH);
+}
+
+std::string RedisResult::asString() const
+{
+    if (!isString()) {
+        throw std::runtime_error("Reply is not a string");
+    }
+    return std::string(reply->str, reply->len);
+}
+
+long long RedisResult::asInteger() const
+{
+    if (!isInteger()) {
+        throw std::runtime_error("Reply is not an integer");
+    }
+    return reply->integer;
+}
+
+bool RedisResult::asBool() const
+{
+    if (reply && reply->type == REDIS_REPLY_BOOL) {
+        return reply->integer != 0;
+    }
+    return asInteger() != 0;
+}
+
+std::string RedisResult::error() const
+{
+    if (!reply) {
+        return "No reply";
+    }
+    if (reply->type != REDIS_REPLY_ERROR) {
+        return "";
+    }
+    return std::string(reply->str, reply->len);
+}
+
+const redisReply* RedisResult::get() const
+{
+    return reply.get();
+}
+
+redisReply* RedisResult::release()
+{
+    return reply.release();
+}
@@ -0,0 +1,269 @@
+#include "redisReplyArena.h"
+
+// System Includes
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr size_t alignment = alignof(std::max_align_t);
+
+    size_t alignUp(size_t size)
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Push replies stay on the heap, push callbacks free them with freeReplyObject
+    bool inPushReply(const redisReadTask* task)
+    {
+        while (task->parent != nullptr) {
+            task = task->parent;
+        }
+        return task->type == REDIS_REPLY_PUSH;
+    }
+
+    void attach(const redisReadTask* task, redisReply* reply)
+    {
+        if (task->parent) {
+            redisReply* parent = static_cast<redisReply*>(task->parent->obj);
+            parent->element[task->idx] = reply;
+        }
+    }
+}
+
+redisReplyObjectFunctions RedisReplyArena::functions = {
+    &RedisReplyArena::createString,
+    &RedisReplyArena::createArray,
+    &RedisReplyArena::createInteger,
+    &RedisReplyArena::createDouble,
+    &RedisReplyArena::createNil,
+    &RedisReplyArena::createBool,
+    &RedisReplyArena::freeObject
+};
+
+thread_local RedisReplyArena* RedisReplyArena::bound = nullptr;
+
+RedisReplyArena::Binding::Binding(redisContext* context, RedisReplyArena& arena)
+    : reader(context->reader), previousFunctions(context->reader->fn),
+      previousPrivdata(context->reader->privdata), previousBound(bound)
+{
+    // Switching functions halfway through a reply would mix arena and heap nodes
+    if (reader->ridx != -1) {
+        throw std::runtime_error("Cannot bind a reply arena in the middle of a reply");
+    }
+    arena.fallback = previousFunctions;
+    reader->fn = &functions;
+    reader->privdata = &arena;
+    bound = &arena;
+}
+
+RedisReplyArena::Binding::~Binding()
+{
+    // A reply cut short by an error points into the arena, drop it rather than let
+    // the heap functions free it later
+    if (reader->ridx != -1 && !inPushReply(reader->task[0])) {
+        reader->ridx = -1;
+        reader->reply = nullptr;
+    }
+    reader->fn = previousFunctions;
+    reader->privdata = previousPrivdata;
+    bound = previousBound;
+}
+
+RedisReplyArena::RedisReplyArena(size_t blockSize, size_t retainBytes)
+    : blockSize(std::max(alignUp(blockSize), alignment)), retainBytes(retainBytes)
+{
+}
+
+void* RedisReplyArena::allocate(size_t size)
+{
+    size = alignUp(std::max<size_t>(size, 1));
+
+    while (current < blocks.size() && offset + size > blocks[current].size) {
+        ++current;
+        offset = 0;
+    }
+
+    if (current == blocks.size()) {
+        // Oversized allocations get a block of their own
+        Block block;
+        block.size = std::max(blockSize, size);
+        block.memory.reset(new char[block.size]);
+        counters.bytesReserved += block.size;
+        blocks.push_back(std::move(block));
+        offset = 0;
+    }
+
+    void* pointer = blocks[current].memory.get() + offset;
+    offset += size;
+    used += size;
+    return pointer;
+}
+
+void RedisReplyArena::reset()
+{
+    counters.resets++;
+    counters.highWater = std::max(counters.highWater, used);
+
+    // Keep the first blocks up to the retain limit, a single huge reply should not
+    // pin its memory forever
+    size_t kept = 0;
+    size_t retained = 0;
+    while (kept < blocks.size() && (kept == 0 || retained + blocks[kept].size <= retainBytes)) {
+        retained += blocks[kept].size;
+        ++kept;
+    }
+    blocks.resize(kept);
+
+    counters.bytesReserved = retained;
+    current = 0;
+    offset = 0;
+    used = 0;
+}
+
+bool RedisReplyArena::owns(const void* pointer) const
+{
+    const char* address = static_cast<const char*>(pointer);
+    for (const Block& block : blocks) {
+        if (address >= block.memory.get() && address < block.memory.get() + block.size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RedisArenaStats RedisReplyArena::stats() const
+{
+    RedisArenaStats snapshot = counters;
+    snapshot.highWater = std::max(snapshot.highWater, used);
+    return snapshot;
+}
+
+RedisReplyArena* RedisReplyArena::arenaOf(const redisReadTask* task)
+{
+    return static_cast<RedisReplyArena*>(task->privdata);
+}
+
+redisReply* RedisReplyArena::createNode(const redisReadTask* task, int type)
+{
+    redisReply* reply = static_cast<redisReply*>(allocate(sizeof(redisReply)));
+    std::memset(reply, 0, sizeof(redisReply));
+    reply->type = type;
+
+    counters.nodes++;
+    if (task->parent == nullptr) {
+        counters.replies++;
+    }
+    attach(task, reply);
+    return reply;
+}
+
+void* RedisReplyArena::createString(const redisReadTask* task, char* str, size_t len)
+{
+    RedisReplyArena* arena = arenaOf(task);
+    if (inPushReply(task)) {
+        return arena->fallback->createString(task, str, len);
+    }
+
+    redisReply* reply = arena->createNode(task, task->type);
+
+    // Verbatim strings carry a "txt:" style type prefix
+    if (task->type == REDIS_REPLY_VERB) {
+        std::memcpy(reply->vtype, str, 3);
+        reply->vtype[3] = '\0';
+        str += 4;
+        len -= 4;
+    }
+
+    char* buffer = static_cast<char*>(arena->allocate(len + 1));
+    std::memcpy(buffer, str, len);
+    buffer[len] = '\0';
+    reply->str = buffer;
+    reply->len = len;
+    return reply;
+}
+
+void* RedisReplyArena::createArray(const redisReadTask* task, size_t elements)
+{
+    RedisReplyArena* arena = arenaOf(task);
+    if (inPushReply(task)) {
+        return arena->fallback->createArray(task, elements);
+    }
+
+    // The element vector is filled in by the children before the node is attached
+    redisReply** element = nullptr;
+    if (elements > 0) {
+        element = static_cast<redisReply**>(arena->allocate(elements * sizeof(redisReply*)));
+        std::memset(element, 0, elements * sizeof(redisReply*));
+    }
+
+    redisReply* reply = arena->createNode(task, task->type);
+    reply->element = element;
+    reply->elements = elements;
+    return reply;
+}
+
+void* RedisReplyArena::createInteger(const redisReadTask* task, long long value)
+{
+    RedisReplyArena* arena = arenaOf(task);
+    if (inPushReply(task)) {
+        return arena->fallback->createInteger(task, value);
+    }
+
+    redisReply* reply = arena->createNode(task, REDIS_REPLY_INTEGER);
+    reply->integer = value;
+    return reply;
+}
+
+void* RedisReplyArena::createDouble(const redisReadTask* task, double value, char* str, size_t len)
+{
+    RedisReplyArena* arena = arenaOf(task);
+    if (inPushReply(task)) {
+        return arena->fallback->createDouble(task, value, str, len);
+    }
+
+    redisReply* reply = arena->createNode(task, REDIS_REPLY_DOUBLE);
+    char* buffer = static_cast<char*>(arena->allocate(len + 1));
+    std::memcpy(buffer, str, len);
+    buffer[len] = '\0';
+    reply->dval = value;
+    reply->str = buffer;
+    reply->len = len;
+    return reply;
+}
+
+void* RedisReplyArena::createNil(const redisReadTask* task)
+{
+    RedisReplyArena* arena = arenaOf(task);
+    if (inPushReply(task)) {
+        return arena->fallback->createNil(task);
+    }
+    return arena->createNode(task, REDIS_REPLY_NIL);
+}
+
+void* RedisReplyArena::createBool(const redisReadTask* task, int value)
+{
+    RedisReplyArena* arena = arenaOf(task);
+    if (inPushReply(task)) {
+        return arena->fallback->createBool(task, value);
+    }
+
+    redisReply* reply = arena->createNode(task, REDIS_REPLY_BOOL);
+    reply->integer = value != 0;
+    return reply;
+}
+
+void RedisReplyArena::freeObject(void* reply)
+{
+    // The reader only frees whole trees it gives up on, arena trees go with the next
+    // reset and heap built push trees are freed normally
+    if (reply == nullptr || (bound != nullptr && bound->owns(reply))) {
+        return;
+    }
+    if (bound != nullptr && bound->fallback != nullptr) {
+        bound->fallback->freeObject(reply);
+        return;
+    }
+    freeReplyObject(reply);
+}
@@ -0,0 +1,339 @@
+#include "redisSentinel.h"
+
+// System Includes
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Project Includes
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    timeval toTimeval(std::chrono::milliseconds interval)
+    {
+        timeval value;
+        value.tv_sec = static_cast<time_t>(interval.count() / 1000);
+        value.tv_usec = static_cast<suseconds_t>((interval.count() % 1000) * 1000);
+        return value;
+    }
+
+    std::string text(const redisReply* reply)
+    {
+        if (reply == nullptr || reply->str == nullptr) {
+            return std::string();
+        }
+        return std::string(reply->str, reply->len);
+    }
+
+    // Value of a field in a flat name/value array, as SENTINEL replicas returns them
+    std::string field(const redisReply* entry, const char* name)
+    {
+        for (size_t i = 0; i + 1 < entry->elements; i += 2) {
+            const redisReply* key = entry->element[i];
+            if (key->str != nullptr && strcmp(key->str, name) == 0) {
+                return text(entry->element[i + 1]);
+            }
+        }
+        return std::string();
+    }
+
+    bool sameEndpoint(const RedisEndpoint& a, const RedisEndpoint& b)
+    {
+        return a.port == b.port && a.host == b.host;
+    }
+}
+
+RedisSentinel::RedisSentinel(RedisSentinelConfig config)
+    : config(std::move(config))
+{
+    if (this->config.sentinels.empty()) {
+        throw std::runtime_error("No Redis Sentinel addresses configured");
+    }
+    if (!resolve()) {
+        throw std::runtime_error("No Redis Sentinel knows master " + this->config.masterName);
+    }
+}
+
+RedisSentinel::~RedisSentinel()
+{
+    stop();
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+}
+
+void RedisSentinel::start(SwitchCallback onSwitch)
+{
+    if (running.load()) {
+        return; // Already running
+    }
+    if (wakeFd < 0) {
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            throw std::runtime_error("Could not create Sentinel wake up descriptor");
+        }
+    }
+    switchCallback = std::move(onSwitch);
+    running.store(true);
+    watcher = std::thread(&RedisSentinel::watch, this);
+}
+
+void RedisSentinel::stop()
+{
+    if (!running.exchange(false)) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+    watcher.join();
+}
+
+bool RedisSentinel::resolve()
+{
+    // The Sentinel that answered last is asked first, the others in order after it
+    const size_t count = config.sentinels.size();
+    const size_t first = preferred.load(std::memory_order_relaxed);
+    for (size_t offset = 0; offset < count; ++offset) {
+        size_t index = (first + offset) % count;
+        redisContext* context = connectSentinel(config.sentinels[index]);
+        if (context == nullptr) {
+            continue;
+        }
+        bool answered = query(context);
+        redisFree(context);
+        if (answered) {
+            preferred.store(index, std::memory_order_relaxed);
+            return true;
+        }
+        sentinelErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    return false;
+}
+
+redisContext* RedisSentinel::connectSentinel(const RedisEndpoint& sentinel)
+{
+    timeval timeout = toTimeval(config.timeout);
+    redisContext* context = redisConnectWithTimeout(sentinel.host.c_str(), sentinel.port, timeout);
+    if (context == nullptr || context->err) {
+        sentinelErrors.fetch_add(1, std::memory_order_relaxed);
+        redisFree(context);
+        return nullptr;
+    }
+    redisSetTimeout(context, timeout);
+    return context;
+}
+
+bool RedisSentinel::query(redisContext* context)
+{
+    redisReply* reply = static_cast<redisReply*>(
+        redisCommand(context, "SENTINEL get-master-addr-by-name %s", config.masterName.c_str()));
+    if (reply == nullptr || reply->type != REDIS_REPLY_ARRAY || reply->elements != 2) {
+        freeReplyObject(reply);
+        return false;
+    }
+    RedisEndpoint master{text(reply->element[0]), std::atoi(text(reply->element[1]).c_str())};
+    freeReplyObject(reply);
+
+    // Replicas that are down or still syncing are left out, before Redis 5 the
+    // command is only known as SENTINEL slaves
+    std::vector<RedisEndpoint> replicas;
+    reply = static_cast<redisReply*>(redisCommand(context, "SENTINEL replicas %s", config.masterName.c_str()));
+    if (reply != nullptr && reply->type == REDIS_REPLY_ERROR) {
+        freeReplyObject(reply);
+        reply = static_cast<redisReply*>(redisCommand(context, "SENTINEL slaves %s", config.masterName.c_str()));
+    }
+    if (reply != nullptr && reply->type == REDIS_REPLY_ARRAY) {
+        for (size_t i = 0; i < reply->elements; ++i) {
+            const redisReply* entry = reply->element[i];
+            if (entry->type != REDIS_REPLY_ARRAY) {
+                continue;
+            }
+            std::string flags = field(entry, "flags");
+            std::string link = field(entry, "master-link-status");
+            if (flags.find("s_down") != std::string::npos || flags.find("o_down") != std::string::npos ||
+                flags.find("disconnected") != std::string::npos || (!link.empty() && link != "ok")) {
+                continue;
+            }
+            replicas.push_back(RedisEndpoint{field(entry, "ip"), std::atoi(field(entry, "port").c_str())});
+        }
+    }
+    freeReplyObject(reply);
+
+    {
+        // Reads stay on the same replica for as long as it is healthy
+        std::lock_guard<std::mutex> lock(addressMutex);
+        healthyReplicas = replicas;
+        auto kept = std::find_if(replicas.begin(), replicas.end(), [this](const RedisEndpoint& replica) {
+            return sameEndpoint(replica, chosenReplica);
+        });
+        if (replicas.empty()) {
+            chosenReplica = RedisEndpoint();
+        } else if (kept == replicas.end()) {
+            thread_local std::mt19937 generator{std::random_device{}()};
+            chosenReplica = replicas[std::uniform_int_distribution<size_t>(0, replicas.size() - 1)(generator)];
+        }
+    }
+    resolves.fetch_add(1, std::memory_order_relaxed);
+    updateMaster(master);
+    return true;
+}
+
+void RedisSentinel::updateMaster(const RedisEndpoint& master)
+{
+    {
+        std::lock_guard<std::mutex> lock(addressMutex);
+        if (sameEndpoint(master, currentMaster)) {
+            return;
+        }
+        bool first = currentMaster.host.empty();
+        currentMaster = master;
+        if (first) {
+            return; // Resolved for the first time, nothing switched
+        }
+        masterGeneration.fetch_add(1, std::memory_order_release);
+    }
+
+    spdlog::warn("Sentinel reports master {} at {}:{}", config.masterName, master.host, master.port);
+    if (switchCallback && running.load()) {
+        switchCallback(master);
+    }
+}
+
+void RedisSentinel::watch()
+{
+    size_t next = preferred.load(std::memory_order_relaxed);
+    while (running.load()) {
+        const RedisEndpoint& sentinel = config.sentinels[next++ % config.sentinels.size()];
+        redisContext* context = connectSentinel(sentinel);
+        if (context != nullptr) {
+            watchSentinel(context);
+            redisFree(context);
+        }
+        if (!pause(config.retryInterval)) {
+            break;
+        }
+    }
+}
+
+void RedisSentinel::watchSentinel(redisContext* context)
+{
+    // Subscribed before the master is asked for again, so a switch in between is not missed.
+    // Replica events refresh the replicas, the other confirmations are read and dropped below
+    redisReply* reply = static_cast<redisReply*>(redisCommand(context, "SUBSCRIBE +switch-master +sdown -sdown +slave"));
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
+        freeReplyObject(reply);
+        sentinelErrors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    freeReplyObject(reply);
+    redisEnableKeepAlive(context);
+    resolve();
+
+    pollfd watched[2] = {{context->fd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    while (running.load() && !context->err) {
+        reply = nullptr;
+        if (redisGetReplyFromReader(context, reinterpret_cast<void**>(&reply)) != REDIS_OK) {
+            break;
+        }
+        if (reply != nullptr) {
+            if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 3 &&
+                text(reply->element[0]) == "message") {
+                handleEvent(text(reply->element[1]), text(reply->element[2]));
+            }
+            freeReplyObject(reply);
+            continue;
+        }
+
+        if (poll(watched, 2, -1) < 0) {
+            continue; // Interrupted by a signal
+        }
+        if (watched[1].revents & POLLIN) {
+            uint64_t wakes = 0;
+            ssize_t drained = read(wakeFd, &wakes, sizeof(wakes));
+            (void)drained;
+        }
+        if ((watched[0].revents & (POLLIN | POLLHUP | POLLERR)) && redisBufferRead(context) != REDIS_OK) {
+            break;
+        }
+    }
+
+    if (running.load()) {
+        sentinelErrors.fetch_add(1, std::memory_order_relaxed);
+        spdlog::warn("Lost Sentinel connection: {}", context->err ? context->errstr : "unexpected reply");
+    }
+}
+
+void RedisSentinel::handleEvent(const std::string& channel, const std::string& payload)
+{
+    std::istringstream fields(payload);
+    if (channel == "+switch-master") {
+        // <master name> <old ip> <old port> <new ip> <new port>
+        std::string name, oldHost, oldPort;
+        RedisEndpoint master;
+        if (fields >> name >> oldHost >> oldPort >> master.host >> master.port && name == config.masterName) {
+            notifications.fetch_add(1, std::memory_order_relaxed);
+            updateMaster(master);
+            resolve();
+        }
+        return;
+    }
+
+    // <type> <name> <ip> <port> @ <master name> <master ip> <master port>
+    if (payload.find("@ " + config.masterName + " ") != std::string::npos) {
+        resolve();
+    }
+}
+
+bool RedisSentinel::pause(std::chrono::milliseconds interval)
+{
+    pollfd watched{wakeFd, POLLIN, 0};
+    poll(&watched, 1, static_cast<int>(interval.count()));
+    return running.load();
+}
+
+RedisEndpoint RedisSentinel::master() const
+{
+    std::lock_guard<std::mutex> lock(addressMutex);
+    return currentMaster;
+}
+
+uint64_t RedisSentinel::generation() const
+{
+    return masterGeneration.load(std::memory_order_acquire);
+}
+
+RedisEndpoint RedisSentinel::replica() const
+{
+    std::lock_guard<std::mutex> lock(addressMutex);
+    return chosenReplica.host.empty() ? currentMaster : chosenReplica;
+}
+
+std::vector<RedisEndpoint> RedisSentinel::replicas() const
+{
+    std::lock_guard<std::mutex> lock(addressMutex);
+    return healthyReplicas;
+}
+
+bool RedisSentinel::readFromReplicas() const
+{
+    return config.readFromReplicas;
+}
+
+RedisSentinelMetrics RedisSentinel::metrics() const
+{
+    RedisSentinelMetrics snapshot;
+    snapshot.switches = masterGeneration.load(std::memory_order_relaxed);
+    snapshot.notifications = notifications.load(std::memory_order_relaxed);
+    snapshot.resolves = resolves.load(std::memory_order_relaxed);
+    snapshot.sentinelErrors = sentinelErrors.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(addressMutex);
+    snapshot.replicas = healthyReplicas.size();
+    return snapshot;
+}
@@ -0,0 +1,97 @@
+#include "redisStream.h"
+
+RedisStreamSink::RedisStreamSink(const RedisElementVisitor& visitor) : root(this), visitor(&visitor)
+{
+}
+
+RedisStreamSink::RedisStreamSink(RedisStreamSink* root, size_t depth) : root(root), depth(depth)
+{
+    owner = root;
+}
+
+void RedisStreamSink::visit(RedisElementView element)
+{
+    element.depth = depth;
+    element.index = index++;
+    if (depth == 1) {
+        root->streamed++;
+    }
+    if (root->visitorFailure) {
+        return;
+    }
+
+    // The visitor runs inside the C reader, nothing may be thrown through it
+    try {
+        (*root->visitor)(element);
+    } catch (...) {
+        root->visitorFailure = std::current_exception();
+    }
+}
+
+void RedisStreamSink::string(int type, const char* str, size_t len)
+{
+    if (depth == 0 && isError(type, str, len)) {
+        return;
+    }
+    RedisElementView element;
+    element.type = type;
+    element.str = std::string_view(str, len);
+    visit(element);
+}
+
+void RedisStreamSink::integer(long long value)
+{
+    RedisElementView element;
+    element.type = REDIS_REPLY_INTEGER;
+    element.integer = value;
+    visit(element);
+}
+
+void RedisStreamSink::number(double value)
+{
+    RedisElementView element;
+    element.type = REDIS_REPLY_DOUBLE;
+    element.number = value;
+    visit(element);
+}
+
+void RedisStreamSink::nil()
+{
+    RedisElementView element;
+    element.type = REDIS_REPLY_NIL;
+    visit(element);
+}
+
+void RedisStreamSink::boolean(bool value)
+{
+    RedisElementView element;
+    element.type = REDIS_REPLY_BOOL;
+    element.integer = value ? 1 : 0;
+    visit(element);
+}
+
+RedisDecodeSink* RedisStreamSink::array(int type, size_t elements)
+{
+    RedisElementView element;
+    element.type = type;
+    element.integer = static_cast<long long>(elements);
+    visit(element);
+
+    if (!child) {
+        child.reset(new RedisStreamSink(root, depth + 1));
+    }
+    child->index = 0;
+    return child.get();
+}
+
+size_t RedisStreamSink::elements() const
+{
+    return root->streamed;
+}
+
+void RedisStreamSink::rethrow() const
+{
+    if (root->visitorFailure) {
+        std::rethrow_exception(root->visitorFailure);
+    }
+}
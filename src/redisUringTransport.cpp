@@ -0,0 +1,639 @@
+#include "redisUringTransport.h"
+
+// System Includes
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Project Includes
+#include <sds.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#define REDIS_CLIENT_HAS_IO_URING 1
+#endif
+#endif
+
+#ifdef REDIS_CLIENT_HAS_IO_URING
+
+namespace
+{
+    // user_data layout, connection slot in the high bits and the operation in the low two
+    enum Operation : uint64_t
+    {
+        SendOperation = 0,
+        ReceiveOperation = 1,
+        CancelOperation = 2,
+        ProbeOperation = 3
+    };
+
+    uint64_t makeTag(size_t slot, Operation operation)
+    {
+        return (static_cast<uint64_t>(slot) << 2) | operation;
+    }
+
+    void setContextError(redisContext* context, int type, const char* message)
+    {
+        context->err = type;
+        snprintf(context->errstr, sizeof(context->errstr), "%s", message);
+    }
+}
+
+struct RedisUringTransport::Connection
+{
+    State* state = nullptr;
+    size_t slot = 0;
+    redisContext* context = nullptr;
+    const redisContextFuncs* original = nullptr;
+    redisContextFuncs funcs = {};
+    char* buffer = nullptr;
+
+    bool sendPending = false;
+    int sendResult = 0;
+
+    // A completed receive is kept until hiredis has read all of it
+    bool receivePending = false;
+    bool receiveReady = false;
+    int receiveResult = 0;
+    size_t receiveOffset = 0;
+};
+
+struct RedisUringTransport::State
+{
+    int ringFd = -1;
+    unsigned features = 0;
+    bool waitAllSends = false;
+    unsigned entries = 0;
+    unsigned toSubmit = 0;
+
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    size_t bufferSize = 0;
+    std::vector<char> storage;
+    std::vector<Connection> connections;
+    Stats stats;
+
+    ~State()
+    {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (ringFd >= 0) {
+            ::close(ringFd);
+        }
+    }
+
+    bool setup(unsigned ringEntries)
+    {
+        io_uring_params params = {};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, ringEntries, &params));
+        if (ringFd < 0) {
+            return false;
+        }
+        features = params.features;
+        entries = params.sq_entries;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (features & IORING_FEAT_SINGLE_MMAP) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        if (features & IORING_FEAT_SINGLE_MMAP) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ringFd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                return false;
+            }
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ringFd, IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool registerBuffers(size_t count, size_t size)
+    {
+        bufferSize = size;
+        storage.assign(count * size, 0);
+
+        std::vector<iovec> iovecs(count);
+        for (size_t i = 0; i < count; ++i) {
+            iovecs[i].iov_base = storage.data() + i * size;
+            iovecs[i].iov_len = size;
+        }
+        return syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS,
+                       iovecs.data(), static_cast<unsigned>(count)) == 0;
+    }
+
+    // Whether a MSG_WAITALL send is retried until every byte is out. Kernels without it
+    // complete a short send successfully, which would leave a linked receive waiting for
+    // a reply to a command the server never got in full. No feature flag reports this,
+    // so a send larger than a small socket buffer is made while the other end drains it
+    bool probeWaitAll()
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            return false;
+        }
+        int small = 4096;
+        setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+
+        std::vector<char> payload(256 * 1024, 'x');
+        io_uring_sqe* sqe = nextSqe();
+        bool sent = false;
+        if (sqe != nullptr) {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = fds[0];
+            sqe->addr = reinterpret_cast<uint64_t>(payload.data());
+            sqe->len = static_cast<uint32_t>(payload.size());
+            sqe->msg_flags = MSG_WAITALL;
+            sqe->user_data = makeTag(0, ProbeOperation);
+            sent = enter(0, nullptr) == 0;
+        }
+
+        // Stops early once nothing arrives for a while, an old kernel sends only part
+        std::vector<char> sink(64 * 1024);
+        size_t drained = 0;
+        pollfd readable = {fds[1], POLLIN, 0};
+        while (sent && drained < payload.size() && poll(&readable, 1, 100) > 0) {
+            ssize_t count = ::read(fds[1], sink.data(), sink.size());
+            if (count <= 0) {
+                break;
+            }
+            drained += static_cast<size_t>(count);
+        }
+
+        int result = -1;
+        if (sent) {
+            while (enter(1, nullptr) == -EINTR) {
+            }
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & *cqMask];
+                if (cqe.user_data == makeTag(0, ProbeOperation)) {
+                    result = cqe.res;
+                }
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return result == static_cast<int>(payload.size());
+    }
+
+    io_uring_sqe* nextSqe()
+    {
+        unsigned tail = *sqTail;
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (tail - head >= entries) {
+            // Submission queue full, hand what we have to the kernel first
+            enter(0, 0);
+            head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            if (tail - head >= entries) {
+                return nullptr;
+            }
+        }
+
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit;
+        return sqe;
+    }
+
+    int enter(unsigned minComplete, const struct timeval* timeout)
+    {
+        unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        void* arg = nullptr;
+        size_t argSize = 0;
+
+        io_uring_getevents_arg eventsArg = {};
+        __kernel_timespec ts = {};
+        if (minComplete > 0 && timeout && (timeout->tv_sec || timeout->tv_usec) &&
+            (features & IORING_FEAT_EXT_ARG)) {
+            ts.tv_sec = timeout->tv_sec;
+            ts.tv_nsec = timeout->tv_usec * 1000;
+            eventsArg.ts = reinterpret_cast<uint64_t>(&ts);
+            flags |= IORING_ENTER_EXT_ARG;
+            arg = &eventsArg;
+            argSize = sizeof(eventsArg);
+        }
+
+        ++stats.enters;
+        long submitted = syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize);
+        if (submitted < 0) {
+            return -errno;
+        }
+        toSubmit -= static_cast<unsigned>(submitted);
+        return 0;
+    }
+
+    void reap()
+    {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes[head & *cqMask];
+            size_t slot = static_cast<size_t>(cqe.user_data >> 2);
+            Operation operation = static_cast<Operation>(cqe.user_data & 3);
+
+            if (slot < connections.size() && operation != CancelOperation) {
+                Connection& connection = connections[slot];
+                if (operation == SendOperation) {
+                    connection.sendPending = false;
+                    connection.sendResult = cqe.res;
+                    if (cqe.res > 0) {
+                        stats.bytesWritten += static_cast<uint64_t>(cqe.res);
+                    }
+                } else {
+                    connection.receivePending = false;
+                    // A receive cancelled by a short send simply gets posted again
+                    if (cqe.res != -ECANCELED) {
+                        connection.receiveReady = true;
+                        connection.receiveResult = cqe.res;
+                        connection.receiveOffset = 0;
+                        if (cqe.res > 0) {
+                            stats.bytesRead += static_cast<uint64_t>(cqe.res);
+                        }
+                    }
+                }
+            }
+            ++head;
+        }
+
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    // Submit anything queued and block until the predicate holds
+    template <typename Predicate>
+    int waitFor(Predicate done, unsigned minComplete, const struct timeval* timeout)
+    {
+        reap();
+        while (!done()) {
+            int result = enter(minComplete, timeout);
+            if (result == -EINTR) {
+                continue;
+            }
+            if (result < 0) {
+                return result;
+            }
+            reap();
+            minComplete = 1;
+        }
+        return 0;
+    }
+
+    bool postReceive(Connection& connection)
+    {
+        io_uring_sqe* sqe = nextSqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = connection.context->fd;
+        sqe->addr = reinterpret_cast<uint64_t>(connection.buffer);
+        sqe->len = static_cast<uint32_t>(bufferSize);
+        sqe->off = 0;
+        sqe->buf_index = static_cast<uint16_t>(connection.slot);
+        sqe->user_data = makeTag(connection.slot, ReceiveOperation);
+
+        connection.receivePending = true;
+        ++stats.receives;
+        return true;
+    }
+
+    // Returns once the operation has completed, the kernel holds its buffer and
+    // socket until then
+    void cancel(Connection& connection, Operation operation, const bool& pending)
+    {
+        if (!pending) {
+            return;
+        }
+
+        // Without room for the cancel the operation is waited out instead
+        io_uring_sqe* sqe = nextSqe();
+        if (sqe != nullptr) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = makeTag(connection.slot, operation);
+            sqe->user_data = makeTag(connection.slot, CancelOperation);
+        }
+        waitFor([&pending]() { return !pending; }, 1, nullptr);
+    }
+
+    // Nothing of a connection may outlive its socket or output buffer: the send still
+    // points into obuf, and bytes received but not yet read belong to the old socket
+    void reset(Connection& connection)
+    {
+        cancel(connection, SendOperation, connection.sendPending);
+        cancel(connection, ReceiveOperation, connection.receivePending);
+        connection.sendResult = 0;
+        connection.receiveReady = false;
+        connection.receiveResult = 0;
+        connection.receiveOffset = 0;
+    }
+};
+
+RedisUringTransport::RedisUringTransport(unsigned maxConnections, size_t bufferSize)
+    : state(std::make_unique<State>())
+{
+    // Each connection can have a send, a receive and a cancel in flight
+    if (!state->setup(maxConnections * 4) || !state->registerBuffers(maxConnections, bufferSize)) {
+        state.reset();
+        return;
+    }
+    state->waitAllSends = state->probeWaitAll();
+    state->stats = Stats();
+
+    state->connections.resize(maxConnections);
+    for (size_t i = 0; i < maxConnections; ++i) {
+        state->connections[i].state = state.get();
+        state->connections[i].slot = i;
+        state->connections[i].buffer = state->storage.data() + i * bufferSize;
+    }
+}
+
+RedisUringTransport::~RedisUringTransport()
+{
+    if (!state) {
+        return;
+    }
+
+    // Contexts that outlive the transport fall back to their original functions
+    for (Connection& connection : state->connections) {
+        if (connection.context == nullptr) {
+            continue;
+        }
+        state->reset(connection);
+        connection.context->funcs = connection.original;
+        connection.context->privdata = nullptr;
+        connection.context->free_privdata = nullptr;
+        connection.context = nullptr;
+    }
+}
+
+bool RedisUringTransport::isSupported()
+{
+    io_uring_params params = {};
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, 1, &params));
+    if (fd < 0) {
+        return false;
+    }
+    ::close(fd);
+    return (params.features & IORING_FEAT_NODROP) != 0;
+}
+
+bool RedisUringTransport::isAvailable() const
+{
+    return state != nullptr;
+}
+
+bool RedisUringTransport::install(redisContext* context)
+{
+    if (!state || context == nullptr || context->err || !(context->flags & REDIS_BLOCK)) {
+        return false;
+    }
+    // The connection is found through privdata, which must be free
+    if (context->privdata != nullptr || context->privctx != nullptr) {
+        return false;
+    }
+
+    for (Connection& connection : state->connections) {
+        if (connection.context != nullptr) {
+            continue;
+        }
+
+        connection.context = context;
+        connection.original = context->funcs;
+        connection.funcs = *context->funcs;
+        connection.funcs.read = &RedisUringTransport::readReply;
+        connection.funcs.write = &RedisUringTransport::writeCommand;
+        connection.funcs.close = &RedisUringTransport::closeConnection;
+        connection.sendPending = false;
+        connection.sendResult = 0;
+        connection.receivePending = false;
+        connection.receiveReady = false;
+        connection.receiveResult = 0;
+        connection.receiveOffset = 0;
+
+        context->funcs = &connection.funcs;
+        context->privdata = &connection;
+        context->free_privdata = &RedisUringTransport::releaseConnection;
+        return true;
+    }
+    return false;
+}
+
+RedisUringTransport::Stats RedisUringTransport::stats() const
+{
+    return state ? state->stats : Stats();
+}
+
+ssize_t RedisUringTransport::writeCommand(redisContext* context)
+{
+    Connection& connection = *static_cast<Connection*>(context->privdata);
+    State& ring = *connection.state;
+
+    io_uring_sqe* sqe = ring.nextSqe();
+    if (sqe == nullptr) {
+        setContextError(context, REDIS_ERR_IO, "io_uring submission queue full");
+        return -1;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = context->fd;
+    sqe->addr = reinterpret_cast<uint64_t>(context->obuf + context->obuf_pos);
+    sqe->len = static_cast<uint32_t>(sdslen(context->obuf) - context->obuf_pos);
+    sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+    sqe->user_data = makeTag(connection.slot, SendOperation);
+    connection.sendPending = true;
+    ++ring.stats.sends;
+
+    // Blocking contexts always read after a write, so the reply is received in the
+    // same system call. MSG_WAITALL fails the link on a short send, which cancels the
+    // receive instead of waiting for a reply the server cannot send yet
+    bool linked = false;
+    if (ring.waitAllSends &&
+        !connection.receivePending && !connection.receiveReady) {
+        sqe->flags |= IOSQE_IO_LINK;
+        linked = ring.postReceive(connection);
+        if (!linked) {
+            sqe->flags &= ~IOSQE_IO_LINK;
+        }
+    }
+
+    int result = ring.waitFor([&connection, linked]() {
+        return !connection.sendPending && (!linked || !connection.receivePending);
+    }, linked ? 2 : 1, context->command_timeout);
+    if (result == -ETIME) {
+        // hiredis frees obuf when it reconnects, the send must be gone by then
+        ring.reset(connection);
+        setContextError(context, REDIS_ERR_TIMEOUT, "send timeout");
+        return -1;
+    }
+    if (result < 0) {
+        ring.reset(connection);
+    }
+    if (result < 0 || connection.sendResult < 0) {
+        setContextError(context, REDIS_ERR_IO, strerror(result < 0 ? -result : -connection.sendResult));
+        return -1;
+    }
+    return connection.sendResult;
+}
+
+ssize_t RedisUringTransport::readReply(redisContext* context, char* buf, size_t bufcap)
+{
+    Connection& connection = *static_cast<Connection*>(context->privdata);
+    State& ring = *connection.state;
+
+    if (!connection.receiveReady) {
+        if (!connection.receivePending && !ring.postReceive(connection)) {
+            setContextError(context, REDIS_ERR_IO, "io_uring submission queue full");
+            return -1;
+        }
+        int result = ring.waitFor([&connection]() {
+            return connection.receiveReady;
+        }, 1, context->command_timeout);
+        if (result == -ETIME) {
+            ring.reset(connection);
+            setContextError(context, REDIS_ERR_TIMEOUT, "recv timeout");
+            return -1;
+        }
+        if (result < 0) {
+            ring.reset(connection);
+            setContextError(context, REDIS_ERR_IO, strerror(-result));
+            return -1;
+        }
+    }
+
+    if (connection.receiveResult == 0) {
+        connection.receiveReady = false;
+        setContextError(context, REDIS_ERR_EOF, "Server closed the connection");
+        return -1;
+    }
+    if (connection.receiveResult < 0) {
+        connection.receiveReady = false;
+        setContextError(context, REDIS_ERR_IO, strerror(-connection.receiveResult));
+        return -1;
+    }
+
+    // Hand out the received bytes, possibly across several calls
+    size_t available = static_cast<size_t>(connection.receiveResult) - connection.receiveOffset;
+    size_t count = available < bufcap ? available : bufcap;
+    memcpy(buf, connection.buffer + connection.receiveOffset, count);
+    connection.receiveOffset += count;
+    if (connection.receiveOffset == static_cast<size_t>(connection.receiveResult)) {
+        connection.receiveReady = false;
+    }
+    return static_cast<ssize_t>(count);
+}
+
+void RedisUringTransport::closeConnection(redisContext* context)
+{
+    // Operations still in flight hold a reference to the socket, they are cancelled
+    // first and whatever was received on it is dropped
+    Connection& connection = *static_cast<Connection*>(context->privdata);
+    connection.state->reset(connection);
+    connection.original->close(context);
+}
+
+void RedisUringTransport::releaseConnection(void* privdata)
+{
+    Connection& connection = *static_cast<Connection*>(privdata);
+    connection.context = nullptr;
+}
+
+#else
+
+// Platforms without io_uring keep every context on the plain socket path
+struct RedisUringTransport::State
+{
+};
+
+RedisUringTransport::RedisUringTransport(unsigned maxConnections, size_t bufferSize)
+{
+    (void)maxConnections;
+    (void)bufferSize;
+}
+
+RedisUringTransport::~RedisUringTransport() = default;
+
+bool RedisUringTransport::isSupported()
+{
+    return false;
+}
+
+bool RedisUringTransport::isAvailable() const
+{
+    return false;
+}
+
+bool RedisUringTransport::install(redisContext* context)
+{
+    (void)context;
+    return false;
+}
+
+RedisUringTransport::Stats RedisUringTransport::stats() const
+{
+    return Stats();
+}
+
+#endif
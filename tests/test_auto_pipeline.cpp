@@ -0,0 +1,175 @@
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisAutoPipeline.h"
+#include "redisCommand.h"
+#include "redisMockServer.h"
+#include "redisReply.h"
+
+// Auto pipelining against the mock server: many callers share one connection, so
+// every reply has to reach the caller whose command it answers. Every check runs, the
+// exit code is non-zero when any of them failed.
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    bool isString(const redisReply* reply, const std::string& value)
+    {
+        return reply != nullptr && reply->str != nullptr && std::string(reply->str, reply->len) == value;
+    }
+
+    RedisEndpoint endpointOf(RedisMockServer& server)
+    {
+        return RedisEndpoint{"127.0.0.1", server.port()};
+    }
+
+    void repliesReachTheirCallers(RedisMockServer& server)
+    {
+        constexpr size_t threads = 8;
+        constexpr size_t rounds = 200;
+        RedisAutoPipeline pipeline(endpointOf(server));
+
+        std::atomic<size_t> mismatched{0};
+        std::vector<std::thread> callers;
+        for (size_t t = 0; t < threads; ++t) {
+            callers.emplace_back([&, t]() {
+                for (size_t i = 0; i < rounds; ++i) {
+                    std::string value = std::to_string(t) + ":" + std::to_string(i);
+                    RedisReplyPtr reply(pipeline.execute(RedisProtocol::formatArgs("ECHO", value)));
+                    if (!isString(reply.get(), value)) {
+                        ++mismatched;
+                    }
+                }
+            });
+        }
+        for (auto& caller : callers) {
+            caller.join();
+        }
+
+        RedisAutoPipelineMetrics metrics = pipeline.metrics();
+        check(mismatched == 0, "every caller gets the reply to its own command");
+        check(metrics.submitted == threads * rounds && metrics.completed == threads * rounds,
+              "every command is submitted and completed once");
+        check(metrics.flushes <= metrics.submitted, "no command is written more than once");
+        check(metrics.failed == 0 && metrics.queueDepth == 0, "nothing failed or is left queued");
+    }
+
+    void multiCommandRequestsStayTogether(RedisMockServer& server)
+    {
+        constexpr size_t threads = 4;
+        constexpr size_t rounds = 200;
+        RedisAutoPipeline pipeline(endpointOf(server));
+
+        // Each request sets a key and reads it back, a command of another caller
+        // between the two would hand back a reply meant for someone else
+        std::atomic<size_t> mismatched{0};
+        std::vector<std::thread> callers;
+        for (size_t t = 0; t < threads; ++t) {
+            callers.emplace_back([&, t]() {
+                std::string key = "auto:" + std::to_string(t);
+                for (size_t i = 0; i < rounds; ++i) {
+                    std::string value = std::to_string(i);
+                    std::string request = RedisProtocol::formatArgs("SET", key, value) +
+                                          RedisProtocol::formatArgs("GET", key);
+                    RedisReplyPtr reply(pipeline.execute(request, 2));
+                    if (!isString(reply.get(), value)) {
+                        ++mismatched;
+                    }
+
+                    RedisReplyPtr echo(pipeline.execute(RedisProtocol::formatArgs("ECHO", key)));
+                    if (!isString(echo.get(), key)) {
+                        ++mismatched;
+                    }
+                }
+            });
+        }
+        for (auto& caller : callers) {
+            caller.join();
+        }
+
+        RedisAutoPipelineMetrics metrics = pipeline.metrics();
+        check(mismatched == 0, "a multi-command request gets the reply to its last command");
+        check(metrics.submitted == threads * rounds * 3 && metrics.completed == metrics.submitted,
+              "every command of a request is counted");
+    }
+
+    void inFlightCommandsFailOnConnectionLoss()
+    {
+        constexpr size_t threads = 4;
+        RedisMockServer server;
+
+        // Replies are held back long enough for the server to go away with every
+        // command still waiting for one
+        RedisMockConfig faults;
+        faults.latency = std::chrono::milliseconds(300);
+        server.setConfig(faults);
+
+        RedisReconnectConfig reconnect;
+        reconnect.initialDelay = std::chrono::milliseconds(5);
+        reconnect.maxAttempts = 1;
+        RedisAutoPipeline pipeline(endpointOf(server), RedisAutoPipelineConfig(), reconnect);
+
+        std::atomic<size_t> threw{0};
+        std::atomic<size_t> answered{0};
+        std::vector<std::thread> callers;
+        for (size_t t = 0; t < threads; ++t) {
+            callers.emplace_back([&, t]() {
+                try {
+                    RedisReplyPtr reply(pipeline.execute(RedisProtocol::formatArgs("ECHO", std::to_string(t))));
+                    ++answered;
+                } catch (const std::runtime_error&) {
+                    ++threw;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        server.stop();
+        for (auto& caller : callers) {
+            caller.join();
+        }
+
+        check(threw == threads && answered == 0, "commands in flight fail when the connection is lost");
+        check(pipeline.metrics().failed == threads, "the failed commands are counted");
+
+        bool refused = false;
+        try {
+            RedisReplyPtr reply(pipeline.execute(RedisProtocol::formatArgs("PING")));
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        check(refused, "commands fail while the server is unreachable");
+    }
+}
+
+int main()
+{
+    RedisMockServer server;
+    repliesReachTheirCallers(server);
+    multiCommandRequestsStayTogether(server);
+    inFlightCommandsFailOnConnectionLoss();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d auto pipeline checks failed\n", failures);
+        return 1;
+    }
+    std::printf("All auto pipeline checks passed\n");
+    return 0;
+}
@@ -0,0 +1,115 @@
+// System Includes
+#include <cstdio>
+#include <string>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisCluster.h"
+
+// Hash slots and redirects of the cluster client, checked against the values Redis
+// Cluster itself computes. Every check runs, the exit code is non-zero when any of
+// them failed.
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    // One reply parsed from its RESP text, the caller frees it
+    redisReply* parse(const std::string& text)
+    {
+        redisReader* reader = redisReaderCreate();
+        redisReaderFeed(reader, text.data(), text.size());
+        void* reply = nullptr;
+        if (redisReaderGetReply(reader, &reply) != REDIS_OK) {
+            reply = nullptr;
+        }
+        redisReaderFree(reader);
+        return static_cast<redisReply*>(reply);
+    }
+
+    bool redirectOf(const std::string& text, RedisCluster::Redirect& redirect)
+    {
+        redisReply* reply = parse(text);
+        bool parsed = reply != nullptr && RedisCluster::parseRedirect(reply, redirect);
+        freeReplyObject(reply);
+        return parsed;
+    }
+
+    void keySlotMatchesCrc16()
+    {
+        // "123456789" is the CRC16-CCITT (XMODEM) check input, its checksum is 0x31C3
+        check(RedisCluster::keySlot("123456789") == 0x31C3, "keySlot of the CRC16 check input");
+        check(RedisCluster::keySlot("") == 0, "keySlot of the empty key");
+        check(RedisCluster::keySlot("foo") == 12182, "keySlot of foo");
+        check(RedisCluster::keySlot("bar") == 5061, "keySlot of bar");
+    }
+
+    void keySlotHashesTheTag()
+    {
+        check(RedisCluster::keySlot("{user1000}.following") == RedisCluster::keySlot("{user1000}.followers"),
+              "keys with the same tag share a slot");
+        check(RedisCluster::keySlot("{user1000}.following") == RedisCluster::keySlot("user1000"),
+              "only the tag is hashed");
+        check(RedisCluster::keySlot("foo{bar}{zap}") == RedisCluster::keySlot("bar"),
+              "the first tag is hashed");
+        check(RedisCluster::keySlot("foo{{bar}}zap") == RedisCluster::keySlot("{bar"),
+              "a tag ends at the first closing brace");
+        check(RedisCluster::keySlot("foo{}{bar}") != RedisCluster::keySlot("") &&
+              RedisCluster::keySlot("foo{}{bar}") != RedisCluster::keySlot("bar"),
+              "an empty tag hashes the whole key");
+        check(RedisCluster::keySlot("foo{bar") != RedisCluster::keySlot("bar"),
+              "an unclosed brace hashes the whole key");
+    }
+
+    void redirectsParse()
+    {
+        RedisCluster::Redirect redirect;
+        check(redirectOf("-MOVED 3999 127.0.0.1:6381\r\n", redirect), "MOVED is parsed");
+        check(!redirect.ask && redirect.slot == 3999 && redirect.host == "127.0.0.1" && redirect.port == 6381,
+              "MOVED slot and address");
+
+        check(redirectOf("-ASK 3999 10.0.0.2:7000\r\n", redirect), "ASK is parsed");
+        check(redirect.ask && redirect.slot == 3999 && redirect.host == "10.0.0.2" && redirect.port == 7000,
+              "ASK slot and address");
+
+        check(redirectOf("-MOVED 12 :7002\r\n", redirect), "MOVED without a host is parsed");
+        check(redirect.host.empty() && redirect.port == 7002, "an empty host is kept empty");
+
+        check(redirectOf("-MOVED 12 ::1:7003\r\n", redirect), "MOVED to an IPv6 address is parsed");
+        check(redirect.host == "::1" && redirect.port == 7003, "the port follows the last colon");
+    }
+
+    void otherRepliesAreNotRedirects()
+    {
+        RedisCluster::Redirect redirect;
+        check(!redirectOf("-ERR unknown command\r\n", redirect), "other errors are not redirects");
+        check(!redirectOf("+MOVED 1 127.0.0.1:7000\r\n", redirect), "status replies are not redirects");
+        check(!redirectOf("$22\r\nMOVED 1 127.0.0.1:7000\r\n", redirect), "bulk strings are not redirects");
+        check(!redirectOf("-MOVED 12\r\n", redirect), "MOVED without an address");
+        check(!redirectOf("-MOVED 12 127.0.0.1\r\n", redirect), "MOVED without a port");
+        check(!redirectOf("-MOVED 12 127.0.0.1:0\r\n", redirect), "MOVED to port 0");
+    }
+}
+
+int main()
+{
+    keySlotMatchesCrc16();
+    keySlotHashesTheTag();
+    redirectsParse();
+    otherRepliesAreNotRedirects();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d cluster slot checks failed\n", failures);
+        return 1;
+    }
+    std::printf("All cluster slot checks passed\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+// System Includes
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisConnectionPool.h"
+#include "redisMockServer.h"
+#include "redisReply.h"
+
+// Checkout of the connection pool against the mock server, with more threads than
+// connections so every checkout past the first few has to wait. Every check runs, the
+// exit code is non-zero when any of them failed.
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    void contendedCheckout(RedisMockServer& server)
+    {
+        constexpr size_t threads = 8;
+        constexpr size_t rounds = 100;
+
+        // Slow replies keep connections checked out long enough for the threads to collide
+        RedisMockConfig faults;
+        faults.latency = std::chrono::microseconds(200);
+        server.setConfig(faults);
+
+        RedisPoolConfig config;
+        config.size = 2;
+        config.acquireTimeout = std::chrono::milliseconds(5000);
+        RedisConnectionPool pool("127.0.0.1", server.port(), config);
+
+        std::mutex heldMutex;
+        std::set<redisContext*> held;
+        std::atomic<size_t> shared{0};
+        std::atomic<size_t> failed{0};
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = 0; i < rounds; ++i) {
+                    RedisConnectionPool::Lease lease = pool.acquire();
+                    {
+                        std::lock_guard<std::mutex> lock(heldMutex);
+                        if (!held.insert(lease.get()).second) {
+                            ++shared;
+                        }
+                    }
+                    RedisReplyPtr reply(static_cast<redisReply*>(redisCommand(lease.get(), "INCR pool:counter")));
+                    if (!reply || reply->type != REDIS_REPLY_INTEGER) {
+                        ++failed;
+                    }
+                    std::lock_guard<std::mutex> lock(heldMutex);
+                    held.erase(lease.get());
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        server.setConfig(RedisMockConfig());
+
+        check(shared == 0, "a connection is never checked out twice at once");
+        check(failed == 0, "every command on a leased connection succeeds");
+
+        RedisReplyPtr counter(static_cast<redisReply*>(redisCommand(pool.acquire().get(), "GET pool:counter")));
+        check(counter && counter->str != nullptr && std::string(counter->str, counter->len) == std::to_string(threads * rounds),
+              "every increment reached the server");
+
+        RedisPoolMetrics metrics = pool.metrics();
+        check(metrics.acquires == threads * rounds + 1, "every checkout is counted");
+        check(metrics.contended > 0, "threads waited for a connection");
+        check(metrics.timeouts == 0, "no checkout timed out");
+        check(metrics.inUse == 0, "every lease was returned");
+    }
+
+    void checkoutTimesOut(RedisMockServer& server)
+    {
+        RedisPoolConfig config;
+        config.size = 1;
+        config.acquireTimeout = std::chrono::milliseconds(20);
+        RedisConnectionPool pool("127.0.0.1", server.port(), config);
+
+        RedisConnectionPool::Lease lease = pool.acquire();
+        bool threw = false;
+        std::thread([&]() {
+            try {
+                pool.acquire();
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+        }).join();
+        check(threw, "checkout of a busy pool throws after acquireTimeout");
+        check(pool.metrics().timeouts == 1, "the timeout is counted");
+
+        lease.release();
+        bool acquired = false;
+        std::thread([&]() { acquired = static_cast<bool>(pool.acquire()); }).join();
+        check(acquired, "a released connection can be checked out again");
+    }
+}
+
+int main()
+{
+    RedisMockServer server;
+    contendedCheckout(server);
+    checkoutTimesOut(server);
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d connection pool checks failed\n", failures);
+        return 1;
+    }
+    std::printf("All connection pool checks passed\n");
+    return 0;
+}
@@ -0,0 +1,283 @@
+// System Includes
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Project Includes
+#include <hiredis.h>
+#include "redisCommand.h"
+#include "redisDecode.h"
+#include "redisMockServer.h"
+
+// Every RedisDecoder specialisation, fed both while the reader parses the reply and
+// from a reply that was already built, and both ways must agree. Replies come from the
+// mock server where it can produce them and from RESP text otherwise. Every check runs,
+// the exit code is non-zero when any of them failed.
+
+namespace
+{
+    using ContextPtr = std::unique_ptr<redisContext, void (*)(redisContext*)>;
+
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    ContextPtr connect(RedisMockServer& server)
+    {
+        ContextPtr context(redisConnect("127.0.0.1", server.port()), redisFree);
+        if (context == nullptr || context->err) {
+            std::fprintf(stderr, "Could not connect to the mock server\n");
+            std::exit(1);
+        }
+        return context;
+    }
+
+    // Decodes the next reply of the context as it is read, throws what check() throws
+    template <typename T>
+    T decodeNext(redisContext* context)
+    {
+        T value{};
+        RedisDecoder<T> decoder(value);
+        {
+            RedisDecodeSink::Binding binding(context, decoder);
+            void* decoded = nullptr;
+            if (redisGetReply(context, &decoded) != REDIS_OK || decoded == nullptr) {
+                throw std::logic_error("No reply to decode");
+            }
+        }
+        decoder.check();
+        return value;
+    }
+
+    template <typename T>
+    T fromServer(redisContext* context, const std::string& formatted)
+    {
+        redisAppendFormattedCommand(context, formatted.data(), formatted.size());
+        return decodeNext<T>(context);
+    }
+
+    // Decodes RESP text through the context's reader, and again from the built reply
+    template <typename T>
+    T fromText(redisContext* context, const std::string& text, bool* agreed = nullptr)
+    {
+        redisReaderFeed(context->reader, text.data(), text.size());
+        T streamed = decodeNext<T>(context);
+
+        redisReader* reader = redisReaderCreate();
+        redisReaderFeed(reader, text.data(), text.size());
+        void* reply = nullptr;
+        redisReaderGetReply(reader, &reply);
+        redisReaderFree(reader);
+        std::unique_ptr<redisReply, void (*)(void*)> built(static_cast<redisReply*>(reply), freeReplyObject);
+        T rebuilt = redisDecode<T>(built.get());
+
+        if (agreed != nullptr) {
+            *agreed = streamed == rebuilt;
+        }
+        return streamed;
+    }
+
+    template <typename T>
+    bool decodes(redisContext* context, const std::string& text, const T& expected)
+    {
+        bool agreed = false;
+        try {
+            return fromText<T>(context, text, &agreed) == expected && agreed;
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "  %s\n", e.what());
+            return false;
+        }
+    }
+
+    // True when decoding fails both ways with a message starting with prefix
+    template <typename T>
+    bool rejects(redisContext* context, const std::string& text, const std::string& prefix)
+    {
+        int thrown = 0;
+        redisReaderFeed(context->reader, text.data(), text.size());
+        try {
+            decodeNext<T>(context);
+        } catch (const std::runtime_error& e) {
+            thrown += std::string(e.what()).rfind(prefix, 0) == 0;
+        }
+
+        redisReader* reader = redisReaderCreate();
+        redisReaderFeed(reader, text.data(), text.size());
+        void* reply = nullptr;
+        redisReaderGetReply(reader, &reply);
+        redisReaderFree(reader);
+        std::unique_ptr<redisReply, void (*)(void*)> built(static_cast<redisReply*>(reply), freeReplyObject);
+        try {
+            redisDecode<T>(built.get());
+        } catch (const std::runtime_error& e) {
+            thrown += std::string(e.what()).rfind(prefix, 0) == 0;
+        }
+        return thrown == 2;
+    }
+
+    void integers(redisContext* context)
+    {
+        check(decodes<int64_t>(context, ":-42\r\n", -42), "integer reply into int64_t");
+        check(decodes<int64_t>(context, "$20\r\n-9223372036854775808\r\n", INT64_MIN), "numeric string into int64_t");
+        check(decodes<uint8_t>(context, ":255\r\n", 255), "largest uint8_t");
+        check(decodes<int16_t>(context, ":-32768\r\n", -32768), "smallest int16_t");
+
+        check(rejects<uint8_t>(context, ":256\r\n", "Reply is out of range"), "integer above uint8_t");
+        check(rejects<int8_t>(context, ":-129\r\n", "Reply is out of range"), "integer below int8_t");
+        check(rejects<uint32_t>(context, ":-1\r\n", "Reply is out of range"), "negative integer into uint32_t");
+        check(rejects<uint16_t>(context, "$5\r\n65536\r\n", "Reply is out of range"), "numeric string above uint16_t");
+        check(rejects<int>(context, "$3\r\n12x\r\n", "Reply is not an integer"), "string with trailing text");
+        check(rejects<int>(context, "#t\r\n", "Unexpected boolean"), "boolean into an integer");
+        check(rejects<int>(context, "*1\r\n:1\r\n", "Unexpected array"), "array into an integer");
+    }
+
+    void floatingPoint(redisContext* context)
+    {
+        check(decodes<double>(context, ",3.25\r\n", 3.25), "RESP3 double");
+        check(decodes<double>(context, ":7\r\n", 7.0), "integer into a double");
+        check(decodes<float>(context, "$4\r\n-1.5\r\n", -1.5f), "numeric string into a float");
+        check(rejects<double>(context, "$3\r\nabc\r\n", "Reply is not a number"), "text into a double");
+        check(rejects<double>(context, "$0\r\n\r\n", "Reply is not a number"), "empty string into a double");
+        check(rejects<double>(context, "_\r\n", "Unexpected nil"), "nil into a double");
+    }
+
+    void booleans(redisContext* context)
+    {
+        check(decodes<bool>(context, "#t\r\n", true), "RESP3 true");
+        check(decodes<bool>(context, "#f\r\n", false), "RESP3 false");
+        check(decodes<bool>(context, ":0\r\n", false), "zero is false");
+        check(decodes<bool>(context, "+OK\r\n", true), "status is true");
+        check(rejects<bool>(context, "$3\r\nyes\r\n", "Expected boolean reply, got string"), "bulk string into a bool");
+    }
+
+    void strings(redisContext* context)
+    {
+        check(decodes<std::string>(context, "$5\r\nhello\r\n", std::string("hello")), "bulk string");
+        check(decodes<std::string>(context, "$4\r\na\r\nb\r\n", std::string("a\r\nb")), "binary safe bulk string");
+        check(decodes<std::string>(context, "+PONG\r\n", std::string("PONG")), "status into a string");
+        check(rejects<std::string>(context, "-ERR boom\r\n", "ERR boom"), "error reply is thrown");
+        check(rejects<std::string>(context, ":1\r\n", "Unexpected integer"), "integer into a string");
+    }
+
+    void optionals(redisContext* context)
+    {
+        check(decodes<std::optional<std::string>>(context, "$-1\r\n", std::nullopt), "RESP2 nil is empty");
+        check(decodes<std::optional<std::string>>(context, "_\r\n", std::nullopt), "RESP3 null is empty");
+        check(decodes<std::optional<int>>(context, ":5\r\n", std::optional<int>(5)), "present value");
+        check(rejects<std::optional<int>>(context, "$1\r\nx\r\n", "Reply is not an integer"),
+              "the value's own errors are kept");
+    }
+
+    void vectors(redisContext* context)
+    {
+        check(decodes<std::vector<int>>(context, "*3\r\n:1\r\n:2\r\n:3\r\n", std::vector<int>{1, 2, 3}),
+              "array of integers");
+        check(decodes<std::vector<int>>(context, "*-1\r\n", std::vector<int>()), "nil array is empty");
+        check(decodes<std::vector<std::vector<std::string>>>(
+                  context, "*2\r\n*1\r\n$1\r\na\r\n*2\r\n$1\r\nb\r\n$1\r\nc\r\n",
+                  std::vector<std::vector<std::string>>{{"a"}, {"b", "c"}}),
+              "nested arrays");
+        check(decodes<std::vector<std::optional<std::string>>>(
+                  context, "*2\r\n$1\r\nv\r\n$-1\r\n",
+                  std::vector<std::optional<std::string>>{std::string("v"), std::nullopt}),
+              "array with nil elements");
+        check(rejects<std::vector<int>>(context, "*2\r\n:1\r\n$3\r\ntwo\r\n", "Reply is not an integer"),
+              "a bad element fails the array");
+        check(rejects<std::vector<int>>(context, "*2\r\n:1\r\n:3000000000\r\n", "Reply is out of range"),
+              "an element out of range fails the array");
+        check(rejects<std::vector<int>>(context, ":1\r\n", "Unexpected integer"), "integer into a vector");
+    }
+
+    void maps(redisContext* context)
+    {
+        using Map = std::map<std::string, int64_t>;
+        using Unordered = std::unordered_map<std::string, std::string>;
+
+        check(decodes<Map>(context, "%2\r\n$1\r\na\r\n:1\r\n$1\r\nb\r\n:2\r\n", Map{{"a", 1}, {"b", 2}}),
+              "RESP3 map");
+        check(decodes<Map>(context, "*4\r\n$1\r\na\r\n:1\r\n$1\r\nb\r\n:2\r\n", Map{{"a", 1}, {"b", 2}}),
+              "RESP2 name/value array");
+        check(decodes<Unordered>(context, "*2\r\n$1\r\nk\r\n$1\r\nv\r\n", Unordered{{"k", "v"}}),
+              "unordered map");
+        check(decodes<std::map<std::string, std::vector<int>>>(
+                  context, "%1\r\n$1\r\nl\r\n*2\r\n:1\r\n:2\r\n",
+                  std::map<std::string, std::vector<int>>{{"l", {1, 2}}}),
+              "map of arrays");
+        check(rejects<Map>(context, "*3\r\n$1\r\na\r\n:1\r\n$1\r\nb\r\n", "Expected map reply, got array"),
+              "odd length array into a map");
+        check(rejects<Map>(context, "%1\r\n$1\r\na\r\n$1\r\nx\r\n", "Reply is not an integer"),
+              "a bad value fails the map");
+    }
+
+    void serverReplies(RedisMockServer& server)
+    {
+        ContextPtr client = connect(server);
+        redisContext* context = client.get();
+
+        check(fromServer<bool>(context, RedisProtocol::formatArgs("SET", "decode:n", "41")), "SET decodes to true");
+        check(fromServer<int64_t>(context, RedisProtocol::formatArgs("INCR", "decode:n")) == 42, "INCR into int64_t");
+        check(fromServer<double>(context, RedisProtocol::formatArgs("GET", "decode:n")) == 42.0, "GET into a double");
+        check(!fromServer<std::optional<std::string>>(context, RedisProtocol::formatArgs("GET", "decode:none")),
+              "GET of a missing key is empty");
+        check(fromServer<std::vector<std::optional<int>>>(context,
+                  RedisProtocol::formatArgs("MGET", "decode:n", "decode:none")) ==
+              std::vector<std::optional<int>>{42, std::nullopt},
+              "MGET into optional integers");
+
+        // HELLO answers with a mixed map, the integer proto field is a mismatch for strings
+        bool mismatched = false;
+        try {
+            fromServer<std::map<std::string, std::string>>(context, RedisProtocol::formatArgs("HELLO", "3"));
+        } catch (const std::runtime_error& e) {
+            mismatched = std::string(e.what()) == "Unexpected integer reply";
+        }
+        check(mismatched, "a mismatched map value is reported");
+        check(fromServer<std::string>(context, RedisProtocol::formatArgs("PING", "after")) == "after",
+              "the connection is usable after a mismatch");
+
+        fromServer<bool>(context, RedisProtocol::formatArgs("SET", "decode:text", "abc"));
+        bool failed = false;
+        try {
+            fromServer<int64_t>(context, RedisProtocol::formatArgs("INCR", "decode:text"));
+        } catch (const std::runtime_error& e) {
+            failed = std::string(e.what()).find("not an integer") != std::string::npos;
+        }
+        check(failed, "an error reply from the server is thrown");
+        check(fromServer<std::string>(context, RedisProtocol::formatArgs("ECHO", "last")) == "last",
+              "the connection is usable after an error reply");
+    }
+}
+
+int main()
+{
+    RedisMockServer server;
+    ContextPtr client = connect(server);
+    integers(client.get());
+    floatingPoint(client.get());
+    booleans(client.get());
+    strings(client.get());
+    optionals(client.get());
+    vectors(client.get());
+    maps(client.get());
+    serverReplies(server);
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d decoder checks failed\n", failures);
+        return 1;
+    }
+    std::printf("All decoder checks passed\n");
+    return 0;
+}
@@ -0,0 +1,146 @@
+// System Includes
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Project Includes
+#include <hiredis.h>
+
+// Edge cases of the RESP reader's integer and double parsing. Doubles the reader
+// accepts must be bit for bit what strtod() returns for the same text, whichever
+// conversion path they take. Every check runs, the exit code is non-zero when any of
+// them failed.
+
+namespace
+{
+    int failures = 0;
+
+    void fail(const std::string& text, const char* what)
+    {
+        std::fprintf(stderr, "FAILED: \"%s\" %s\n", text.c_str(), what);
+        ++failures;
+    }
+
+    // Feeds one reply line of the given type, null when the reader rejects it
+    redisReply* parse(char type, const std::string& text)
+    {
+        std::string line = type + text + "\r\n";
+        redisReader* reader = redisReaderCreate();
+        redisReaderFeed(reader, line.data(), line.size());
+        void* reply = nullptr;
+        if (redisReaderGetReply(reader, &reply) != REDIS_OK) {
+            reply = nullptr;
+        }
+        redisReaderFree(reader);
+        return static_cast<redisReply*>(reply);
+    }
+
+    void integerIs(const std::string& text, long long expected)
+    {
+        redisReply* reply = parse(':', text);
+        if (reply == nullptr || reply->type != REDIS_REPLY_INTEGER) {
+            fail(text, "was rejected");
+        } else if (reply->integer != expected) {
+            fail(text, "parsed to the wrong value");
+        }
+        freeReplyObject(reply);
+    }
+
+    void integerRejected(const std::string& text)
+    {
+        redisReply* reply = parse(':', text);
+        if (reply != nullptr) {
+            fail(text, "was accepted");
+        }
+        freeReplyObject(reply);
+    }
+
+    void doubleMatchesStrtod(const std::string& text)
+    {
+        redisReply* reply = parse(',', text);
+        double expected = std::strtod(text.c_str(), nullptr);
+        if (reply == nullptr || reply->type != REDIS_REPLY_DOUBLE) {
+            fail(text, "was rejected");
+        } else if (std::memcmp(&reply->dval, &expected, sizeof(double)) != 0) {
+            fail(text, "differs from strtod");
+        }
+        freeReplyObject(reply);
+    }
+
+    void doubleRejected(const std::string& text)
+    {
+        redisReply* reply = parse(',', text);
+        if (reply != nullptr) {
+            fail(text, "was accepted");
+        }
+        freeReplyObject(reply);
+    }
+}
+
+int main()
+{
+    integerIs("0", 0);
+    integerIs("-1", -1);
+    integerIs("999999999999999999", 999999999999999999LL);
+    integerIs("-999999999999999999", -999999999999999999LL);
+    integerIs("1000000000000000000", 1000000000000000000LL);
+    integerIs("9223372036854775807", 9223372036854775807LL);
+    integerIs("-9223372036854775808", -9223372036854775807LL - 1);
+    integerRejected("9223372036854775808");
+    integerRejected("-9223372036854775809");
+    integerRejected("-0");
+    integerRejected("007");
+    integerRejected("-07");
+    integerRejected("");
+    integerRejected("-");
+    integerRejected("12a");
+    integerRejected("+5");
+
+    // Within the fast conversion: at most 15 digits and an exponent within 22
+    doubleMatchesStrtod("0");
+    doubleMatchesStrtod("-0");
+    doubleMatchesStrtod("-0.0");
+    doubleMatchesStrtod(".5");
+    doubleMatchesStrtod("5.");
+    doubleMatchesStrtod("+2.5");
+    doubleMatchesStrtod("3.14159");
+    doubleMatchesStrtod("007.25");
+    doubleMatchesStrtod("1e22");
+    doubleMatchesStrtod("1e-22");
+    doubleMatchesStrtod("123456789012345e22");
+    doubleMatchesStrtod("123456789012345e-22");
+    doubleMatchesStrtod("1.5E+3");
+    doubleMatchesStrtod("999999999999999");
+
+    // Past it, strtod() converts them
+    doubleMatchesStrtod("1e23");
+    doubleMatchesStrtod("1e-23");
+    doubleMatchesStrtod("1234567890123456");
+    doubleMatchesStrtod("0.1000000000000001");
+    doubleMatchesStrtod("9007199254740993");
+    doubleMatchesStrtod("1e308");
+    doubleMatchesStrtod("4.9e-324");
+
+    doubleRejected("1e");
+    doubleRejected("1e+");
+    doubleRejected(".");
+    doubleRejected("-");
+    doubleRejected("1.2.3");
+    doubleRejected("1e400");
+    doubleRejected("infinity");
+
+    redisReply* infinite = parse(',', "-inf");
+    if (infinite == nullptr || !std::isinf(infinite->dval) || infinite->dval > 0) {
+        fail("-inf", "is not negative infinity");
+    }
+    freeReplyObject(infinite);
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d reader checks failed\n", failures);
+        return 1;
+    }
+    std::printf("All reader checks passed\n");
+    return 0;
+}